@@ -10,6 +10,9 @@
 /* DMA controller hard-coded destination address */
 #define DEST_ADDRESS 0x2004
 
+/* DMA controller transfers a whole page */
+#define TRANSFER_SIZE 256
+
 static bool nes_sprite_init(struct controller_instance *instance);
 static void nes_sprite_deinit(struct controller_instance *instance);
 static void nes_sprite_writeb(region_data_t *data, uint8_t b,
@@ -27,17 +30,15 @@ void nes_sprite_writeb(region_data_t *data, uint8_t b,
 	address_t UNUSED(address))
 {
 	struct nes_sprite *nes_sprite = data;
+	uint8_t buf[TRANSFER_SIZE];
 	uint16_t src_address;
-	int i;
 
 	/* Input byte represents upper byte of source address */
 	src_address = b << 8;
 
-	/* Transfers 256 bytes */
-	for (i = 0; i < 256; i++) {
-		b = memory_readb(nes_sprite->bus_id, src_address++);
-		memory_writeb(nes_sprite->bus_id, b, DEST_ADDRESS);
-	}
+	/* Transfer 256 bytes from source page to destination port */
+	memory_read_block(nes_sprite->bus_id, src_address, buf, TRANSFER_SIZE);
+	memory_write_port(nes_sprite->bus_id, DEST_ADDRESS, buf, TRANSFER_SIZE);
 
 	/* The transfer takes 512 clock cycles and halts execution unit */
 	clock_consume(512);
@@ -18,6 +18,7 @@ struct gb_mapper {
 	uint8_t *rom0;
 	uint16_t rom0_size;
 	bool bootrom_locked;
+	struct controller_instance *mbc_instance;
 };
 
 static bool gb_mapper_init(struct controller_instance *instance);
@@ -45,17 +46,9 @@ void lock_writeb(region_data_t *data, uint8_t b, address_t UNUSED(address))
 	/* Update state */
 	gb_mapper->bootrom_locked = true;
 
-	/* Unmap boot ROM and remove its region */
+	/* Swap boot ROM region for beginning of ROM0 and unmap boot ROM */
+	memory_region_swap(gb_mapper->bootrom_area, &rom_mops, gb_mapper->rom0);
 	memory_unmap_file(gb_mapper->bootrom, gb_mapper->bootrom_size);
-	memory_region_remove(gb_mapper->bootrom_area);
-
-	/* Unmap ROM0 */
-	memory_unmap_file(gb_mapper->rom0, gb_mapper->rom0_size);
-	memory_region_remove(gb_mapper->rom0_area);
-
-	/* Remap ROM0 after changing its start address */
-	gb_mapper->rom0_area->data.mem.start -= gb_mapper->bootrom_size;
-	map_rom0(gb_mapper);
 }
 
 bool map_bootrom(struct gb_mapper *gb_mapper)
@@ -84,26 +77,25 @@ bool map_bootrom(struct gb_mapper *gb_mapper)
 
 bool map_rom0(struct gb_mapper *gb_mapper)
 {
-	int offset;
+	struct resource area;
 
 	/* Compute mapped size */
 	gb_mapper->rom0_size = gb_mapper->rom0_area->data.mem.end -
 		gb_mapper->rom0_area->data.mem.start + 1;
 
-	/* Set offset based on boot ROM state */
-	offset = gb_mapper->bootrom_locked ? 0 : gb_mapper->bootrom_size;
-
-	/* Map ROM0 after boot ROM */
-	gb_mapper->rom0 = memory_map_file(gb_mapper->mach_data->cart_path,
-		offset, gb_mapper->rom0_size);
-	if (!gb_mapper->rom0) {
-		LOG_E("Could not map cart from \"%s\"!\n",
-			gb_mapper->mach_data->cart_path);
+	/* Check if cart image contains whole ROM0 */
+	if (gb_mapper->mach_data->cart_size < gb_mapper->rom0_size)
 		return false;
-	}
 
-	/* Add ROM0 memory region */
-	memory_region_add(gb_mapper->rom0_area, &rom_mops, gb_mapper->rom0);
+	/* Use whole ROM0 (boot ROM is swapped for its beginning when locked) */
+	gb_mapper->rom0 = gb_mapper->mach_data->cart;
+
+	/* Add ROM0 memory region after boot ROM (machine resources are shared
+	between instances so adjust a copy) */
+	area = *gb_mapper->rom0_area;
+	area.data.mem.start += gb_mapper->bootrom_size;
+	memory_region_add(&area, &rom_mops,
+		gb_mapper->rom0 + gb_mapper->bootrom_size);
 	return true;
 }
 
@@ -122,16 +114,32 @@ bool gb_mapper_init(struct controller_instance *instance)
 	/* Save machine data */
 	gb_mapper->mach_data = instance->mach_data;
 
-	/* Map cart header */
-	cart_header = memory_map_file(gb_mapper->mach_data->cart_path,
-		CART_HEADER_START, sizeof(struct cart_header));
-	if (!cart_header) {
-		LOG_E("Could not map header from \"%s\"!\n",
+	/* Map whole cart image once (MBCs use views into it) */
+	gb_mapper->mach_data->cart = memory_map_image(
+		gb_mapper->mach_data->cart_path,
+		&gb_mapper->mach_data->cart_size);
+	if (!gb_mapper->mach_data->cart) {
+		LOG_E("Could not map cart from \"%s\"!\n",
+			gb_mapper->mach_data->cart_path);
+		free(gb_mapper);
+		return false;
+	}
+
+	/* Check if cart image contains header */
+	if (gb_mapper->mach_data->cart_size <
+		(int)(CART_HEADER_START + sizeof(struct cart_header))) {
+		LOG_E("Could not find header in \"%s\"!\n",
 			gb_mapper->mach_data->cart_path);
+		memory_unmap_file(gb_mapper->mach_data->cart,
+			gb_mapper->mach_data->cart_size);
 		free(gb_mapper);
 		return false;
 	}
 
+	/* Get cart header from cart image */
+	cart_header = (struct cart_header *)(gb_mapper->mach_data->cart +
+		CART_HEADER_START);
+
 	/* Print header info */
 	LOG_I("Title: %.*s\n", TITLE_SIZE, cart_header->title);
 	LOG_I("Manufacturer code: %.*s\n", MANUFACTURER_CODE_SIZE,
@@ -152,12 +160,11 @@ bool gb_mapper_init(struct controller_instance *instance)
 	/* Get cart type number */
 	number = cart_header->cartridge_type;
 
-	/* Unmap cart header */
-	memory_unmap_file(cart_header, sizeof(struct cart_header));
-
 	/* Check if cart type is supported */
 	if ((number >= ARRAY_SIZE(mbcs)) || !mbcs[number]) {
 		LOG_E("Cart type %u is not supported!\n", number);
+		memory_unmap_file(gb_mapper->mach_data->cart,
+			gb_mapper->mach_data->cart_size);
 		free(gb_mapper);
 		return false;
 	}
@@ -174,15 +181,18 @@ bool gb_mapper_init(struct controller_instance *instance)
 
 	/* Map boot ROM */
 	if (!map_bootrom(gb_mapper)) {
+		memory_unmap_file(gb_mapper->mach_data->cart,
+			gb_mapper->mach_data->cart_size);
 		free(gb_mapper);
 		LOG_E("Could not map boot ROM!\n");
 		return false;
 	}
 
-	/* Map ROM0 after changing its start address */
-	gb_mapper->rom0_area->data.mem.start += gb_mapper->bootrom_size;
+	/* Map ROM0 */
 	if (!map_rom0(gb_mapper)) {
 		memory_unmap_file(gb_mapper->bootrom, gb_mapper->bootrom_size);
+		memory_unmap_file(gb_mapper->mach_data->cart,
+			gb_mapper->mach_data->cart_size);
 		free(gb_mapper);
 		LOG_E("Could not map ROM0!\n");
 		return false;
@@ -202,7 +212,7 @@ bool gb_mapper_init(struct controller_instance *instance)
 	mbc_instance->num_resources = instance->num_resources;
 	mbc_instance->resources = instance->resources;
 	mbc_instance->mach_data = instance->mach_data;
-	instance->priv_data = mbc_instance;
+	gb_mapper->mbc_instance = mbc_instance;
 	controller_add(mbc_instance);
 
 	return true;
@@ -216,9 +226,11 @@ void gb_mapper_deinit(struct controller_instance *instance)
 	if (!gb_mapper->bootrom_locked)
 		memory_unmap_file(gb_mapper->bootrom, gb_mapper->bootrom_size);
 
-	/* Unmap ROM0 */
-	memory_unmap_file(gb_mapper->rom0, gb_mapper->rom0_size);
+	/* Unmap cart image */
+	memory_unmap_file(gb_mapper->mach_data->cart,
+		gb_mapper->mach_data->cart_size);
 
+	free(gb_mapper->mbc_instance);
 	free(gb_mapper);
 }
 
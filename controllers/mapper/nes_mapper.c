@@ -23,18 +23,28 @@ bool nes_mapper_init(struct controller_instance *instance)
 	struct cart_header *cart_header;
 	uint8_t number;
 
-	/* Map cart header */
-	cart_header = memory_map_file(mach_data->path, 0,
-		sizeof(struct cart_header));
-	if (!cart_header) {
-		LOG_E("Could not map header from \"%s\"!\n", mach_data->path);
+	/* Map whole cart image once (mappers use views into it) */
+	mach_data->cart = memory_map_image(mach_data->path,
+		&mach_data->cart_size);
+	if (!mach_data->cart) {
+		LOG_E("Could not map cart from \"%s\"!\n", mach_data->path);
 		return false;
 	}
 
 	/* Validate header */
-	if (cart_header->ines_constant != INES_CONSTANT) {
+	cart_header = (struct cart_header *)mach_data->cart;
+	if ((mach_data->cart_size < (int)sizeof(struct cart_header)) ||
+		(cart_header->ines_constant != INES_CONSTANT)) {
 		LOG_E("Cart header does not have valid format!\n");
-		memory_unmap_file(cart_header, sizeof(struct cart_header));
+		memory_unmap_file(mach_data->cart, mach_data->cart_size);
+		return false;
+	}
+
+	/* Validate cart image size */
+	if (mach_data->cart_size < (int)(CHR_ROM_OFFSET(cart_header) +
+		CHR_ROM_SIZE(cart_header))) {
+		LOG_E("Cart image is too small for its header!\n");
+		memory_unmap_file(mach_data->cart, mach_data->cart_size);
 		return false;
 	}
 
@@ -51,12 +61,10 @@ bool nes_mapper_init(struct controller_instance *instance)
 	/* Bits 4-7 of flags 7 contain the mapper number upper nibble */
 	number = (cart_header->flags6 >> 4) | (cart_header->flags7 & 0xF0);
 
-	/* Unmap cart header */
-	memory_unmap_file(cart_header, sizeof(struct cart_header));
-
 	/* Check if mapper is supported */
 	if ((number >= ARRAY_SIZE(mappers)) || !mappers[number]) {
 		LOG_I("Mapper %u is not supported!\n", number);
+		memory_unmap_file(mach_data->cart, mach_data->cart_size);
 		return false;
 	}
 
@@ -75,6 +83,8 @@ bool nes_mapper_init(struct controller_instance *instance)
 
 void nes_mapper_deinit(struct controller_instance *instance)
 {
+	struct nes_mapper_mach_data *mach_data = instance->mach_data;
+	memory_unmap_file(mach_data->cart, mach_data->cart_size);
 	free(instance->priv_data);
 }
 
@@ -3,13 +3,16 @@
 #include <memory.h>
 #include <controllers/mapper/nes_mapper.h>
 
+#define PRG_ROM_BANK_SIZE	KB(16)
+#define NUM_PRG_ROM_BANKS	2
+
 struct nrom {
 	bool vertical_mirroring;
 	uint8_t *vram;
 	uint8_t *prg_rom;
 	int prg_rom_size;
+	struct resource prg_rom_banks[NUM_PRG_ROM_BANKS];
 	uint8_t *chr_rom;
-	int chr_rom_size;
 };
 
 static bool nrom_init(struct controller_instance *instance);
@@ -19,8 +22,6 @@ static uint16_t vram_readw(region_data_t *data, address_t address);
 static void vram_writeb(region_data_t *data, uint8_t b, address_t address);
 static void vram_writew(region_data_t *data, uint16_t w, address_t address);
 static void mirror_address(struct nrom *nrom, address_t *address);
-static uint8_t prg_rom_readb(region_data_t *data, address_t address);
-static uint16_t prg_rom_readw(region_data_t *data, address_t address);
 
 static struct mops vram_mops = {
 	.readb = vram_readb,
@@ -29,11 +30,6 @@ static struct mops vram_mops = {
 	.writew = vram_writew
 };
 
-static struct mops prg_rom_mops = {
-	.readb = prg_rom_readb,
-	.readw = prg_rom_readw
-};
-
 uint8_t vram_readb(region_data_t *data, address_t address)
 {
 	struct nrom *nrom = data;
@@ -83,42 +79,21 @@ void mirror_address(struct nrom *nrom, address_t *address)
 	}
 }
 
-uint8_t prg_rom_readb(region_data_t *data, address_t address)
-{
-	struct nrom *nrom = data;
-
-	/* Handle NROM-128 mirroring */
-	address %= nrom->prg_rom_size;
-
-	return *(nrom->prg_rom + address);
-}
-
-uint16_t prg_rom_readw(region_data_t *data, address_t address)
-{
-	struct nrom *nrom = data;
-	uint8_t *mem;
-
-	/* Handle NROM-128 mirroring */
-	address %= nrom->prg_rom_size;
-
-	mem = nrom->prg_rom + address;
-	return (*(mem + 1) << 8) | *mem;
-}
-
 bool nrom_init(struct controller_instance *instance)
 {
 	struct nrom *nrom;
 	struct nes_mapper_mach_data *mach_data = instance->mach_data;
 	struct cart_header *cart_header;
 	struct resource *area;
+	address_t start;
+	int i;
 
 	/* Allocate NROM structure */
 	instance->priv_data = malloc(sizeof(struct nrom));
 	nrom = instance->priv_data;
 
-	/* Map cart header */
-	cart_header = memory_map_file(mach_data->path, 0,
-		sizeof(struct cart_header));
+	/* Get cart header from cart image */
+	cart_header = (struct cart_header *)mach_data->cart;
 
 	/* Get mirroring information (used for VRAM access) - NROM supports
 	only horizontal and vertical mirroring */
@@ -134,44 +109,46 @@ bool nrom_init(struct controller_instance *instance)
 		instance->num_resources);
 	memory_region_add(area, &vram_mops, nrom);
 
-	/* Allocate and fill PRG ROM data */
+	/* Get PRG ROM data from cart image */
 	nrom->prg_rom_size = PRG_ROM_SIZE(cart_header);
-	nrom->prg_rom = memory_map_file(mach_data->path,
-		PRG_ROM_OFFSET(cart_header),
-		nrom->prg_rom_size);
+	nrom->prg_rom = mach_data->cart + PRG_ROM_OFFSET(cart_header);
 
-	/* Fill and add PRG ROM region */
+	/* Split PRG ROM area in 16KB banks and add their regions */
 	area = resource_get("prg_rom",
 		RESOURCE_MEM,
 		instance->resources,
 		instance->num_resources);
-	memory_region_add(area, &prg_rom_mops, nrom);
+	for (i = 0; i < NUM_PRG_ROM_BANKS; i++) {
+		start = area->data.mem.start + i * PRG_ROM_BANK_SIZE;
+		nrom->prg_rom_banks[i] = (struct resource)MEM("prg_rom_bank",
+			area->data.mem.bus_id,
+			start,
+			start + PRG_ROM_BANK_SIZE - 1);
+		memory_region_add(&nrom->prg_rom_banks[i], &rom_mops,
+			nrom->prg_rom);
+	}
 
-	/* Allocate and fill CHR ROM data */
-	nrom->chr_rom_size = CHR_ROM_SIZE(cart_header);
-	nrom->chr_rom = memory_map_file(mach_data->path,
-		CHR_ROM_OFFSET(cart_header),
-		nrom->chr_rom_size);
+	/* Bind second bank (NROM-128 mirrors first bank) */
+	if (nrom->prg_rom_size > PRG_ROM_BANK_SIZE)
+		memory_region_rebind(&nrom->prg_rom_banks[1],
+			nrom->prg_rom + PRG_ROM_BANK_SIZE);
 
-	/* Fill and add PRG ROM region */
+	/* Get CHR ROM data from cart image */
+	nrom->chr_rom = mach_data->cart + CHR_ROM_OFFSET(cart_header);
+
+	/* Add CHR ROM region */
 	area = resource_get("chr",
 		RESOURCE_MEM,
 		instance->resources,
 		instance->num_resources);
 	memory_region_add(area, &rom_mops, nrom->chr_rom);
 
-	/* Unmap cart header */
-	memory_unmap_file(cart_header, sizeof(struct cart_header));
-
 	return true;
 }
 
 void nrom_deinit(struct controller_instance *instance)
 {
-	struct nrom *nrom = instance->priv_data;
-	memory_unmap_file(nrom->chr_rom, nrom->chr_rom_size);
-	memory_unmap_file(nrom->prg_rom, nrom->prg_rom_size);
-	free(nrom);
+	free(instance->priv_data);
 }
 
 CONTROLLER_START(nrom)
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <controller.h>
+#include <log.h>
 #include <memory.h>
 #include <controllers/mapper/gb_mapper.h>
 
@@ -7,7 +8,6 @@
 #define BANK_SIZE	KB(16)
 
 static bool rom_init(struct controller_instance *instance);
-static void rom_deinit(struct controller_instance *instance);
 
 bool rom_init(struct controller_instance *instance)
 {
@@ -15,8 +15,14 @@ bool rom_init(struct controller_instance *instance)
 	struct resource *area;
 	uint8_t *bank;
 
-	/* Map second ROM bank */
-	bank = memory_map_file(mach_data->cart_path, BANK_START, BANK_SIZE);
+	/* Check if cart image contains second ROM bank */
+	if (mach_data->cart_size < BANK_START + BANK_SIZE) {
+		LOG_E("Could not find second ROM bank in cart!\n");
+		return false;
+	}
+
+	/* Get second ROM bank from cart image */
+	bank = mach_data->cart + BANK_START;
 
 	/* Add second ROM bank */
 	area = resource_get("rom1",
@@ -25,20 +31,10 @@ bool rom_init(struct controller_instance *instance)
 		instance->num_resources);
 	memory_region_add(area, &rom_mops, bank);
 
-	/* Save private data */
-	instance->priv_data = bank;
-
 	return true;
 }
 
-void rom_deinit(struct controller_instance *instance)
-{
-	uint8_t *bank = instance->priv_data;
-	memory_unmap_file(bank, BANK_SIZE);
-}
-
 CONTROLLER_START(rom)
-	.init = rom_init,
-	.deinit = rom_deinit
+	.init = rom_init
 CONTROLLER_END
 
@@ -108,6 +108,7 @@ struct lcdc {
 	};
 	int h;
 	int v;
+	uint64_t cycle;
 	int *events[NUM_LINES];
 	int visible_scanline[NUM_CYCLES_PER_LINE];
 	int vblank_scanline[NUM_CYCLES_PER_LINE];
@@ -124,6 +125,10 @@ typedef void (*lcdc_event_t)(struct lcdc *lcdc);
 static bool lcdc_init(struct controller_instance *instance);
 static void lcdc_deinit(struct controller_instance *instance);
 static void lcdc_tick(clock_data_t *data);
+static void lcdc_run(struct lcdc *lcdc, uint64_t end_cycle);
+static int lcdc_get_line_distance(int v, int h, int first_line, int last_line,
+	int event_h);
+static int lcdc_get_sync_distance(struct lcdc *lcdc);
 static void lcdc_update_counters(struct lcdc *lcdc);
 static void lcdc_set_events(struct lcdc *lcdc);
 static uint8_t lcdc_readb(region_data_t *data, address_t address);
@@ -152,6 +157,9 @@ uint8_t lcdc_readb(region_data_t *data, address_t address)
 {
 	struct lcdc *lcdc = data;
 
+	/* Catch up with CPU before accessing LCDC state */
+	lcdc_run(lcdc, clock_get_sync_cycle(&lcdc->clock));
+
 	switch (address) {
 	case DMA:
 		/* DMA register is write-only */
@@ -165,12 +173,22 @@ void lcdc_writeb(region_data_t *data, uint8_t b, address_t address)
 {
 	struct lcdc *lcdc = data;
 	uint16_t source_addr;
-	int i;
+
+	/* Catch up with CPU before accessing LCDC state */
+	lcdc_run(lcdc, clock_get_sync_cycle(&lcdc->clock));
 
 	switch (address) {
+	case CTRL:
+		/* Write register and reschedule as display may be toggled */
+		lcdc->regs[CTRL] = b;
+		clock_wake(&lcdc->clock);
+		break;
 	case STAT:
 		/* Bits 0-2 are read-only so only set bits 3-6 */
 		bitops_setb(&lcdc->regs[STAT], 3, 4, bitops_getb(&b, 3, 4));
+
+		/* Reschedule as interrupt sources may have changed */
+		clock_wake(&lcdc->clock);
 		break;
 	case LYC:
 		/* Register is read-only */
@@ -178,10 +196,8 @@ void lcdc_writeb(region_data_t *data, uint8_t b, address_t address)
 	case DMA:
 		/* Handle DMA (data byte represents upper 8 bits of source) */
 		source_addr = b << 8;
-		for (i = 0; i < DMA_TRANSFER_SIZE; i++) {
-			b = memory_readb(lcdc->bus_id, source_addr);
-			memory_writeb(lcdc->bus_id, b, DMA_DEST_ADDRESS);
-		}
+		memory_copy_block(lcdc->bus_id, DMA_DEST_ADDRESS,
+			lcdc->bus_id, source_addr, DMA_TRANSFER_SIZE);
 		break;
 	default:
 		lcdc->regs[address] = b;
@@ -372,32 +388,102 @@ void lcdc_update_counters(struct lcdc *lcdc)
 		lcdc->v = 0;
 }
 
-void lcdc_tick(clock_data_t *data)
+void lcdc_run(struct lcdc *lcdc, uint64_t end_cycle)
 {
-	struct lcdc *lcdc = data;
 	int event_mask;
 	int pos;
-	int num_cycles = 0;
+	int num_cycles;
 
-	/* Get event mask for current cycle */
-	event_mask = lcdc->events[lcdc->v][lcdc->h];
+	/* Process events until end cycle (exclusive) is reached */
+	while (lcdc->cycle < end_cycle) {
+		/* Get event mask for current cycle */
+		event_mask = lcdc->events[lcdc->v][lcdc->h];
+
+		/* Loop through all events and fire them if LCD is enabled */
+		while ((pos = bitops_ffs(event_mask))) {
+			if (lcdc->ctrl.lcd_display_enable)
+				lcdc_events[pos - 1](lcdc);
+			event_mask &= ~BIT(pos - 1);
+		}
 
-	/* Loop through all events and fire them if LCD is enabled */
-	while ((pos = bitops_ffs(event_mask))) {
-		if (lcdc->ctrl.lcd_display_enable)
-			lcdc_events[pos - 1](lcdc);
-		event_mask &= ~BIT(pos - 1);
+		/* Update counters until next event is found */
+		num_cycles = 0;
+		do {
+			lcdc_update_counters(lcdc);
+			event_mask = lcdc->events[lcdc->v][lcdc->h];
+			num_cycles++;
+		} while (!event_mask);
+
+		/* Advance to next event cycle */
+		lcdc->cycle += num_cycles;
 	}
+}
 
-	/* Update counters until next event is found */
-	do {
-		lcdc_update_counters(lcdc);
-		event_mask = lcdc->events[lcdc->v][lcdc->h];
-		num_cycles++;
-	} while (!event_mask);
+int lcdc_get_line_distance(int v, int h, int first_line, int last_line,
+	int event_h)
+{
+	int line;
+
+	/* Find next line of range on which event is still ahead (wrapping to
+	next frame if needed) */
+	line = (h <= event_h) ? v : v + 1;
+	if (line < first_line)
+		line = first_line;
+	if (line > last_line)
+		line = first_line + NUM_LINES;
+
+	/* Return number of cycles until event */
+	return (line - v) * NUM_CYCLES_PER_LINE + event_h - h;
+}
+
+int lcdc_get_sync_distance(struct lcdc *lcdc)
+{
+	int h = lcdc->h;
+	int v = lcdc->v;
+	int num_cycles;
+	int n;
+
+	/* VBLANK always fires an interrupt and updates the screen (it also
+	bounds how far the LCDC can lag behind while the LCD is disabled) */
+	num_cycles = lcdc_get_line_distance(v, h, 144, 144, 0);
+
+	/* Other events do nothing while the LCD is disabled */
+	if (!lcdc->ctrl.lcd_display_enable)
+		return num_cycles;
+
+	/* Line drawing reads VRAM, which the CPU accesses directly */
+	n = lcdc_get_line_distance(v, h, 0, 143, 252);
+	if (n < num_cycles)
+		num_cycles = n;
+
+	/* OAM interrupt and screen lock at first line */
+	n = lcdc_get_line_distance(v, h, 0,
+		lcdc->stat.mode_2_oam_interrupt ? 143 : 0, 0);
+	if (n < num_cycles)
+		num_cycles = n;
+
+	/* Coincidence interrupt */
+	if (lcdc->stat.coincidence_interrupt && (lcdc->lyc < NUM_LINES)) {
+		n = lcdc_get_line_distance(v, h, lcdc->lyc, lcdc->lyc, 0);
+		if (n < num_cycles)
+			num_cycles = n;
+	}
+
+	return num_cycles;
+}
+
+void lcdc_tick(clock_data_t *data)
+{
+	struct lcdc *lcdc = data;
+	uint64_t sync_cycle;
+
+	/* Process pending events up to current cycle (included) */
+	lcdc_run(lcdc, lcdc->clock.num_cycles + 1);
 
-	/* Report cycle consumption */
-	clock_consume(num_cycles);
+	/* Sleep until next event visible outside of the LCDC (other events are
+	processed lazily, whenever the CPU accesses LCDC registers) */
+	sync_cycle = lcdc->cycle + lcdc_get_sync_distance(lcdc);
+	clock_consume(sync_cycle - lcdc->clock.num_cycles);
 }
 
 bool lcdc_init(struct controller_instance *instance)
@@ -451,6 +537,7 @@ bool lcdc_init(struct controller_instance *instance)
 	memset(lcdc->regs, 0, NUM_REGS * sizeof(uint8_t));
 	lcdc->h = 0;
 	lcdc->v = 0;
+	lcdc->cycle = lcdc->clock.num_cycles;
 	lcdc->ly = 0;
 	lcdc->stat.mode_flag = 2;
 
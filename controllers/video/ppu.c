@@ -37,6 +37,10 @@
 #define NUM_CHROMA_VALUES	16
 #define NUM_LUMA_VALUES		4
 
+/* Dot positions of events having effects outside of the PPU */
+#define VBLANK_SET_DOT		(241 * NUM_DOTS + 1)
+#define VBLANK_CLEAR_DOT	(261 * NUM_DOTS + 1)
+
 /* PPU events sorted by priority */
 #define EVENT_SHIFT_BG		BIT(0)
 #define EVENT_RELOAD_BG		BIT(1)
@@ -151,6 +155,7 @@ struct ppu {
 	bool odd_frame;
 	int h;
 	int v;
+	uint64_t cycle;
 	int *events[NUM_SCANLINES];
 	int visible_scanline[NUM_DOTS];
 	int vblank_scanline[NUM_DOTS];
@@ -168,6 +173,8 @@ typedef void (*ppu_event_t)(struct ppu *ppu);
 static bool ppu_init(struct controller_instance *instance);
 static void ppu_deinit(struct controller_instance *instance);
 static void ppu_tick(clock_data_t *data);
+static void ppu_run(struct ppu *ppu, uint64_t end_cycle);
+static int ppu_get_sync_distance(struct ppu *ppu);
 static void ppu_update_counters(struct ppu *ppu);
 static void ppu_set_events(struct ppu *ppu);
 static uint8_t ppu_readb(region_data_t *data, address_t address);
@@ -253,6 +260,9 @@ uint8_t ppu_readb(region_data_t *data, address_t address)
 	struct ppu *ppu = data;
 	uint8_t b;
 
+	/* Catch up with CPU before accessing PPU state */
+	ppu_run(ppu, clock_get_sync_cycle(&ppu->clock));
+
 	switch (address) {
 	case PPUSTATUS:
 		/* w: = 0 */
@@ -282,6 +292,9 @@ void ppu_writeb(region_data_t *data, uint8_t b, address_t address)
 	struct ppu *ppu = data;
 	uint16_t t;
 
+	/* Catch up with CPU before accessing PPU state */
+	ppu_run(ppu, clock_get_sync_cycle(&ppu->clock));
+
 	switch (address) {
 	case PPUCTRL:
 		/* Write register */
@@ -697,31 +710,62 @@ void ppu_update_counters(struct ppu *ppu)
 		ppu->h++;
 }
 
-void ppu_tick(clock_data_t *data)
+void ppu_run(struct ppu *ppu, uint64_t end_cycle)
 {
-	struct ppu *ppu = data;
 	int event_mask;
 	int pos;
-	int num_cycles = 0;
+	int num_cycles;
 
-	/* Get event mask for current cycle */
-	event_mask = ppu->events[ppu->v][ppu->h];
+	/* Process events until end cycle (exclusive) is reached */
+	while (ppu->cycle < end_cycle) {
+		/* Get event mask for current cycle */
+		event_mask = ppu->events[ppu->v][ppu->h];
+
+		/* Loop through all events and fire them */
+		while ((pos = bitops_ffs(event_mask))) {
+			ppu_events[pos - 1](ppu);
+			event_mask &= ~BIT(pos - 1);
+		}
 
-	/* Loop through all events and fire them */
-	while ((pos = bitops_ffs(event_mask))) {
-		ppu_events[pos - 1](ppu);
-		event_mask &= ~BIT(pos - 1);
+		/* Update h/v counters until next event is found */
+		num_cycles = 0;
+		do {
+			ppu_update_counters(ppu);
+			event_mask = ppu->events[ppu->v][ppu->h];
+			num_cycles++;
+		} while (!event_mask);
+
+		/* Advance to next event cycle */
+		ppu->cycle += num_cycles;
 	}
+}
 
-	/* Update h/v counters until next event is found */
-	do {
-		ppu_update_counters(ppu);
-		event_mask = ppu->events[ppu->v][ppu->h];
-		num_cycles++;
-	} while (!event_mask);
+int ppu_get_sync_distance(struct ppu *ppu)
+{
+	int dot = ppu->v * NUM_DOTS + ppu->h;
+
+	/* Return number of dots until next VBLANK set or clear event */
+	if (dot <= VBLANK_SET_DOT)
+		return VBLANK_SET_DOT - dot;
+	if (dot <= VBLANK_CLEAR_DOT)
+		return VBLANK_CLEAR_DOT - dot;
+
+	/* Assume next frame skips its first dot (waking up early is safe) */
+	return NUM_SCANLINES * NUM_DOTS - dot + VBLANK_SET_DOT - 1;
+}
+
+void ppu_tick(clock_data_t *data)
+{
+	struct ppu *ppu = data;
+	uint64_t sync_cycle;
+
+	/* Process pending events up to current cycle (included) */
+	ppu_run(ppu, ppu->clock.num_cycles + 1);
 
-	/* Report cycle consumption */
-	clock_consume(num_cycles);
+	/* Sleep until next event visible outside of the PPU (other events are
+	processed lazily, whenever the CPU accesses PPU registers) */
+	sync_cycle = ppu->cycle + ppu_get_sync_distance(ppu);
+	clock_consume(sync_cycle - ppu->clock.num_cycles);
 }
 
 bool ppu_init(struct controller_instance *instance)
@@ -772,6 +816,7 @@ bool ppu_init(struct controller_instance *instance)
 	ppu->odd_frame = false;
 	ppu->h = 0;
 	ppu->v = 261;
+	ppu->cycle = ppu->clock.num_cycles;
 
 	/* Prepare frame events */
 	ppu_set_events(ppu);
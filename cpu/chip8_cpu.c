@@ -553,8 +553,8 @@ void chip8_tick(clock_data_t *data)
 	struct chip8 *chip8 = data;
 
 	/* Fetch opcode */
-	uint8_t o1 = memory_readb(chip8->bus_id, chip8->PC++);
-	uint8_t o2 = memory_readb(chip8->bus_id, chip8->PC++);
+	uint8_t o1 = memory_fetchb(chip8->bus_id, chip8->PC++);
+	uint8_t o2 = memory_fetchb(chip8->bus_id, chip8->PC++);
 	chip8->opcode.raw = (o1 << 8) | o2;
 
 	/* Execute opcode */
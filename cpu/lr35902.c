@@ -1,8 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <bitops.h>
 #include <clock.h>
+#include <cmdline.h>
+#include <config.h>
 #include <cpu.h>
+#ifdef CONFIG_CPU_LR35902_JIT
+#include <jit.h>
+#endif
 #include <log.h>
 #include <memory.h>
 #include <util.h>
@@ -31,6 +37,174 @@
 #define INT_VECTOR(irq) \
 	(0x40 + (irq << 3))
 
+/* CB opcode fields (operation, bit/shift operation and register index) */
+#define CB_OPERATION(opcode)	(opcode >> 6)
+#define CB_BIT(opcode)		((opcode >> 3) & 0x07)
+#define CB_REGISTER(opcode)	(opcode & 0x07)
+#define CB_SHIFT		0
+#define CB_TEST			1
+#define CB_RES			2
+#define CB_SET			3
+
+/* Register indexes used by opcode fields (index 6 is memory at HL) */
+#define NUM_REGISTERS		8
+
+/* Translated blocks are looked up per 256-byte page of address space */
+#define NUM_JIT_PAGES		(0x10000 >> BUS_PAGE_BITS)
+
+/* Translated blocks share a code buffer and hold a limited instruction count */
+#define JIT_BUFFER_SIZE		KB(1024)
+#define MAX_BLOCK_INSTRUCTIONS	32
+
+/* 8-bit ALU instruction operating on a register, immediate or (HL) */
+#define ALU_INSTRUCTION(name, op) \
+	static inline void name##_r(struct lr35902 *cpu, uint8_t *r) \
+	{ \
+		op(cpu, *r); \
+		clock_consume(4); \
+	} \
+	static inline void name##_n(struct lr35902 *cpu) \
+	{ \
+		op(cpu, memory_readb(cpu->bus_id, cpu->PC++)); \
+		clock_consume(8); \
+	} \
+	static inline void name##_cHL(struct lr35902 *cpu) \
+	{ \
+		op(cpu, memory_readb(cpu->bus_id, cpu->HL)); \
+		clock_consume(8); \
+	}
+
+/* Opcode map (CB-prefixed opcodes are decoded by lr35902_opcode_CB) */
+#define LR35902_OPCODES(OP) \
+	OP(0x00, NOP) OP(0x01, LD_rr_nn, &cpu->BC) \
+	OP(0x02, LD_cBC_A) OP(0x03, INC_rr, &cpu->BC) \
+	OP(0x04, INC_r, &cpu->B) OP(0x05, DEC_r, &cpu->B) \
+	OP(0x06, LD_r_n, &cpu->B) OP(0x07, RLCA) \
+	OP(0x08, LD_cnn_SP) OP(0x09, ADD_HL_rr, &cpu->BC) \
+	OP(0x0A, LD_A_cBC) OP(0x0B, DEC_rr, &cpu->BC) \
+	OP(0x0C, INC_r, &cpu->C) OP(0x0D, DEC_r, &cpu->C) \
+	OP(0x0E, LD_r_n, &cpu->C) OP(0x0F, RRCA) \
+	OP(0x10, STOP) OP(0x11, LD_rr_nn, &cpu->DE) \
+	OP(0x12, LD_cDE_A) OP(0x13, INC_rr, &cpu->DE) \
+	OP(0x14, INC_r, &cpu->D) OP(0x15, DEC_r, &cpu->D) \
+	OP(0x16, LD_r_n, &cpu->D) OP(0x17, RLA) \
+	OP(0x18, JR_d) OP(0x19, ADD_HL_rr, &cpu->DE) \
+	OP(0x1A, LD_A_cDE) OP(0x1B, DEC_rr, &cpu->DE) \
+	OP(0x1C, INC_r, &cpu->E) OP(0x1D, DEC_r, &cpu->E) \
+	OP(0x1E, LD_r_n, &cpu->E) OP(0x1F, RRA) \
+	OP(0x20, JR_NZ_d) OP(0x21, LD_rr_nn, &cpu->HL) \
+	OP(0x22, LDI_cHL_A) OP(0x23, INC_rr, &cpu->HL) \
+	OP(0x24, INC_r, &cpu->H) OP(0x25, DEC_r, &cpu->H) \
+	OP(0x26, LD_r_n, &cpu->H) OP(0x27, DAA) \
+	OP(0x28, JR_Z_d) OP(0x29, ADD_HL_rr, &cpu->HL) \
+	OP(0x2A, LDI_A_cHL) OP(0x2B, DEC_rr, &cpu->HL) \
+	OP(0x2C, INC_r, &cpu->L) OP(0x2D, DEC_r, &cpu->L) \
+	OP(0x2E, LD_r_n, &cpu->L) OP(0x2F, CPL) \
+	OP(0x30, JR_NC_d) OP(0x31, LD_rr_nn, &cpu->SP) \
+	OP(0x32, LDD_cHL_A) OP(0x33, INC_rr, &cpu->SP) \
+	OP(0x34, INC_cHL) OP(0x35, DEC_cHL) \
+	OP(0x36, LD_cHL_n) OP(0x37, SCF) \
+	OP(0x38, JR_C_d) OP(0x39, ADD_HL_rr, &cpu->SP) \
+	OP(0x3A, LDD_A_cHL) OP(0x3B, DEC_rr, &cpu->SP) \
+	OP(0x3C, INC_r, &cpu->A) OP(0x3D, DEC_r, &cpu->A) \
+	OP(0x3E, LD_r_n, &cpu->A) OP(0x3F, CCF) \
+	OP(0x40, LD_r_r, &cpu->B, &cpu->B) OP(0x41, LD_r_r, &cpu->B, &cpu->C) \
+	OP(0x42, LD_r_r, &cpu->B, &cpu->D) OP(0x43, LD_r_r, &cpu->B, &cpu->E) \
+	OP(0x44, LD_r_r, &cpu->B, &cpu->H) OP(0x45, LD_r_r, &cpu->B, &cpu->L) \
+	OP(0x46, LD_r_cHL, &cpu->B) OP(0x47, LD_r_r, &cpu->B, &cpu->A) \
+	OP(0x48, LD_r_r, &cpu->C, &cpu->B) OP(0x49, LD_r_r, &cpu->C, &cpu->C) \
+	OP(0x4A, LD_r_r, &cpu->C, &cpu->D) OP(0x4B, LD_r_r, &cpu->C, &cpu->E) \
+	OP(0x4C, LD_r_r, &cpu->C, &cpu->H) OP(0x4D, LD_r_r, &cpu->C, &cpu->L) \
+	OP(0x4E, LD_r_cHL, &cpu->C) OP(0x4F, LD_r_r, &cpu->C, &cpu->A) \
+	OP(0x50, LD_r_r, &cpu->D, &cpu->B) OP(0x51, LD_r_r, &cpu->D, &cpu->C) \
+	OP(0x52, LD_r_r, &cpu->D, &cpu->D) OP(0x53, LD_r_r, &cpu->D, &cpu->E) \
+	OP(0x54, LD_r_r, &cpu->D, &cpu->H) OP(0x55, LD_r_r, &cpu->D, &cpu->L) \
+	OP(0x56, LD_r_cHL, &cpu->D) OP(0x57, LD_r_r, &cpu->D, &cpu->A) \
+	OP(0x58, LD_r_r, &cpu->E, &cpu->B) OP(0x59, LD_r_r, &cpu->E, &cpu->C) \
+	OP(0x5A, LD_r_r, &cpu->E, &cpu->D) OP(0x5B, LD_r_r, &cpu->E, &cpu->E) \
+	OP(0x5C, LD_r_r, &cpu->E, &cpu->H) OP(0x5D, LD_r_r, &cpu->E, &cpu->L) \
+	OP(0x5E, LD_r_cHL, &cpu->E) OP(0x5F, LD_r_r, &cpu->E, &cpu->A) \
+	OP(0x60, LD_r_r, &cpu->H, &cpu->B) OP(0x61, LD_r_r, &cpu->H, &cpu->C) \
+	OP(0x62, LD_r_r, &cpu->H, &cpu->D) OP(0x63, LD_r_r, &cpu->H, &cpu->E) \
+	OP(0x64, LD_r_r, &cpu->H, &cpu->H) OP(0x65, LD_r_r, &cpu->H, &cpu->L) \
+	OP(0x66, LD_r_cHL, &cpu->H) OP(0x67, LD_r_r, &cpu->H, &cpu->A) \
+	OP(0x68, LD_r_r, &cpu->L, &cpu->B) OP(0x69, LD_r_r, &cpu->L, &cpu->C) \
+	OP(0x6A, LD_r_r, &cpu->L, &cpu->D) OP(0x6B, LD_r_r, &cpu->L, &cpu->E) \
+	OP(0x6C, LD_r_r, &cpu->L, &cpu->H) OP(0x6D, LD_r_r, &cpu->L, &cpu->L) \
+	OP(0x6E, LD_r_cHL, &cpu->L) OP(0x6F, LD_r_r, &cpu->L, &cpu->A) \
+	OP(0x70, LD_cHL_r, &cpu->B) OP(0x71, LD_cHL_r, &cpu->C) \
+	OP(0x72, LD_cHL_r, &cpu->D) OP(0x73, LD_cHL_r, &cpu->E) \
+	OP(0x74, LD_cHL_r, &cpu->H) OP(0x75, LD_cHL_r, &cpu->L) \
+	OP(0x76, HALT) OP(0x77, LD_cHL_r, &cpu->A) \
+	OP(0x78, LD_r_r, &cpu->A, &cpu->B) OP(0x79, LD_r_r, &cpu->A, &cpu->C) \
+	OP(0x7A, LD_r_r, &cpu->A, &cpu->D) OP(0x7B, LD_r_r, &cpu->A, &cpu->E) \
+	OP(0x7C, LD_r_r, &cpu->A, &cpu->H) OP(0x7D, LD_r_r, &cpu->A, &cpu->L) \
+	OP(0x7E, LD_r_cHL, &cpu->A) OP(0x7F, LD_r_r, &cpu->A, &cpu->A) \
+	OP(0x80, ADD_A_r, &cpu->B) OP(0x81, ADD_A_r, &cpu->C) \
+	OP(0x82, ADD_A_r, &cpu->D) OP(0x83, ADD_A_r, &cpu->E) \
+	OP(0x84, ADD_A_r, &cpu->H) OP(0x85, ADD_A_r, &cpu->L) \
+	OP(0x86, ADD_A_cHL) OP(0x87, ADD_A_r, &cpu->A) \
+	OP(0x88, ADC_A_r, &cpu->B) OP(0x89, ADC_A_r, &cpu->C) \
+	OP(0x8A, ADC_A_r, &cpu->D) OP(0x8B, ADC_A_r, &cpu->E) \
+	OP(0x8C, ADC_A_r, &cpu->H) OP(0x8D, ADC_A_r, &cpu->L) \
+	OP(0x8E, ADC_A_cHL) OP(0x8F, ADC_A_r, &cpu->A) \
+	OP(0x90, SUB_A_r, &cpu->B) OP(0x91, SUB_A_r, &cpu->C) \
+	OP(0x92, SUB_A_r, &cpu->D) OP(0x93, SUB_A_r, &cpu->E) \
+	OP(0x94, SUB_A_r, &cpu->H) OP(0x95, SUB_A_r, &cpu->L) \
+	OP(0x96, SUB_A_cHL) OP(0x97, SUB_A_r, &cpu->A) \
+	OP(0x98, SBC_A_r, &cpu->B) OP(0x99, SBC_A_r, &cpu->C) \
+	OP(0x9A, SBC_A_r, &cpu->D) OP(0x9B, SBC_A_r, &cpu->E) \
+	OP(0x9C, SBC_A_r, &cpu->H) OP(0x9D, SBC_A_r, &cpu->L) \
+	OP(0x9E, SBC_A_cHL) OP(0x9F, SBC_A_r, &cpu->A) \
+	OP(0xA0, AND_r, &cpu->B) OP(0xA1, AND_r, &cpu->C) \
+	OP(0xA2, AND_r, &cpu->D) OP(0xA3, AND_r, &cpu->E) \
+	OP(0xA4, AND_r, &cpu->H) OP(0xA5, AND_r, &cpu->L) \
+	OP(0xA6, AND_cHL) OP(0xA7, AND_r, &cpu->A) \
+	OP(0xA8, XOR_r, &cpu->B) OP(0xA9, XOR_r, &cpu->C) \
+	OP(0xAA, XOR_r, &cpu->D) OP(0xAB, XOR_r, &cpu->E) \
+	OP(0xAC, XOR_r, &cpu->H) OP(0xAD, XOR_r, &cpu->L) \
+	OP(0xAE, XOR_cHL) OP(0xAF, XOR_r, &cpu->A) \
+	OP(0xB0, OR_r, &cpu->B) OP(0xB1, OR_r, &cpu->C) \
+	OP(0xB2, OR_r, &cpu->D) OP(0xB3, OR_r, &cpu->E) \
+	OP(0xB4, OR_r, &cpu->H) OP(0xB5, OR_r, &cpu->L) \
+	OP(0xB6, OR_cHL) OP(0xB7, OR_r, &cpu->A) \
+	OP(0xB8, CP_r, &cpu->B) OP(0xB9, CP_r, &cpu->C) \
+	OP(0xBA, CP_r, &cpu->D) OP(0xBB, CP_r, &cpu->E) \
+	OP(0xBC, CP_r, &cpu->H) OP(0xBD, CP_r, &cpu->L) \
+	OP(0xBE, CP_cHL) OP(0xBF, CP_r, &cpu->A) \
+	OP(0xC0, RET_NZ) OP(0xC1, POP_rr, &cpu->BC) \
+	OP(0xC2, JP_NZ_nn) OP(0xC3, JP_nn) \
+	OP(0xC4, CALL_NZ_nn) OP(0xC5, PUSH_rr, &cpu->BC) \
+	OP(0xC6, ADD_A_n) OP(0xC7, RST_n, 0x00) \
+	OP(0xC8, RET_Z) OP(0xC9, RET) \
+	OP(0xCA, JP_Z_nn) OP(0xCB, lr35902_opcode_CB) \
+	OP(0xCC, CALL_Z_nn) OP(0xCD, CALL_nn) \
+	OP(0xCE, ADC_A_n) OP(0xCF, RST_n, 0x08) \
+	OP(0xD0, RET_NC) OP(0xD1, POP_rr, &cpu->DE) \
+	OP(0xD2, JP_NC_nn) OP(0xD3, UNK) \
+	OP(0xD4, CALL_NC_nn) OP(0xD5, PUSH_rr, &cpu->DE) \
+	OP(0xD6, SUB_A_n) OP(0xD7, RST_n, 0x10) \
+	OP(0xD8, RET_C) OP(0xD9, RETI) \
+	OP(0xDA, JP_C_nn) OP(0xDB, UNK) \
+	OP(0xDC, CALL_C_nn) OP(0xDD, UNK) \
+	OP(0xDE, SBC_A_n) OP(0xDF, RST_n, 0x18) \
+	OP(0xE0, LD_cFF00pn_A) OP(0xE1, POP_rr, &cpu->HL) \
+	OP(0xE2, LD_cFF00pC_A) OP(0xE3, UNK) \
+	OP(0xE4, UNK) OP(0xE5, PUSH_rr, &cpu->HL) \
+	OP(0xE6, AND_n) OP(0xE7, RST_n, 0x20) \
+	OP(0xE8, ADD_SP_d) OP(0xE9, JP_HL) \
+	OP(0xEA, LD_cnn_A) OP(0xEB, UNK) \
+	OP(0xEC, UNK) OP(0xED, UNK) \
+	OP(0xEE, XOR_n) OP(0xEF, RST_n, 0x28) \
+	OP(0xF0, LD_A_cFF00pn) OP(0xF1, POP_AF) \
+	OP(0xF2, LD_A_cFF00pC) OP(0xF3, DI) \
+	OP(0xF4, UNK) OP(0xF5, PUSH_rr, &cpu->AF) \
+	OP(0xF6, OR_n) OP(0xF7, RST_n, 0x30) \
+	OP(0xF8, LD_HL_SPpd) OP(0xF9, LD_SP_HL) \
+	OP(0xFA, LD_A_cnn) OP(0xFB, EI) \
+	OP(0xFC, UNK) OP(0xFD, UNK) \
+	OP(0xFE, CP_n) OP(0xFF, RST_n, 0x38)
+
 struct lr35902_flags {
 	uint8_t reserved:4;
 	uint8_t C:1;
@@ -50,16 +224,65 @@ struct lr35902 {
 	uint8_t IF;
 	uint8_t IE;
 	bool halted;
+	uint8_t *regs[NUM_REGISTERS];
 	int bus_id;
+#ifdef CONFIG_CPU_LR35902_JIT
+	struct lr35902_jit_page *jit_pages[NUM_JIT_PAGES];
+	struct jit *jit;
+	enum jit_mode jit_mode;
+	unsigned int jit_generation;
+	unsigned int *jit_bus_generation;
+	uint8_t *jit_open_bus;
+#endif
 	struct clock clock;
 };
 
+#ifdef CONFIG_CPU_LR35902_JIT
+struct lr35902_jit_page {
+	unsigned int generation;
+	jit_block_t blocks[BUS_PAGE_SIZE];
+};
+#endif
+
 static bool lr35902_init(struct cpu_instance *instance);
 static void lr35902_interrupt(struct cpu_instance *instance, int irq);
 static void lr35902_deinit(struct cpu_instance *instance);
+static inline int lr35902_get_interrupt(struct lr35902 *cpu);
 static bool lr35902_handle_interrupts(struct lr35902 *cpu);
 static void lr35902_tick(clock_data_t *data);
-static void lr35902_opcode_CB(struct lr35902 *cpu);
+#ifndef CONFIG_CPU_LR35902_THREADED
+static void lr35902_step(struct lr35902 *cpu);
+#endif
+#ifdef CONFIG_CPU_LR35902_JIT
+static bool lr35902_jit_decode(struct bus *bus, uint16_t address,
+	uint8_t *opcode);
+static bool lr35902_jit_ends_block(uint8_t opcode);
+static bool lr35902_jit_has_side_effects(struct bus *bus, uint16_t address,
+	uint8_t opcode);
+static jit_block_t lr35902_jit_translate(struct lr35902 *cpu, bool retry);
+static jit_block_t lr35902_jit_get_block(struct lr35902 *cpu);
+static void lr35902_jit_flush(struct lr35902 *cpu);
+static void lr35902_jit_tick(clock_data_t *data);
+#endif
+static inline void lr35902_opcode_CB(struct lr35902 *cpu);
+static inline void ADD(struct lr35902 *cpu, uint8_t b);
+static inline void ADC(struct lr35902 *cpu, uint8_t b);
+static inline void SUB(struct lr35902 *cpu, uint8_t b);
+static inline void SBC(struct lr35902 *cpu, uint8_t b);
+static inline void AND(struct lr35902 *cpu, uint8_t b);
+static inline void XOR(struct lr35902 *cpu, uint8_t b);
+static inline void OR(struct lr35902 *cpu, uint8_t b);
+static inline void CP(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t INC(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t DEC(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t RLC(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t RRC(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t RL(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t RR(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t SLA(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t SRA(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t SWAP(struct lr35902 *cpu, uint8_t b);
+static inline uint8_t SRL(struct lr35902 *cpu, uint8_t b);
 static inline void LD_r_r(struct lr35902 *cpu, uint8_t *r1, uint8_t *r2);
 static inline void LD_r_n(struct lr35902 *cpu, uint8_t *r);
 static inline void LD_r_cHL(struct lr35902 *cpu, uint8_t *r);
@@ -85,30 +308,6 @@ static inline void PUSH_rr(struct lr35902 *cpu, uint16_t *rr);
 static inline void POP_rr(struct lr35902 *cpu, uint16_t *rr);
 static inline void POP_AF(struct lr35902 *cpu);
 static inline void LD_cnn_SP(struct lr35902 *cpu);
-static inline void ADD_A_r(struct lr35902 *cpu, uint8_t *r);
-static inline void ADD_A_n(struct lr35902 *cpu);
-static inline void ADD_A_cHL(struct lr35902 *cpu);
-static inline void ADC_A_r(struct lr35902 *cpu, uint8_t *r);
-static inline void ADC_A_n(struct lr35902 *cpu);
-static inline void ADC_A_cHL(struct lr35902 *cpu);
-static inline void SUB_A_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SUB_A_n(struct lr35902 *cpu);
-static inline void SUB_A_cHL(struct lr35902 *cpu);
-static inline void SBC_A_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SBC_A_n(struct lr35902 *cpu);
-static inline void SBC_A_cHL(struct lr35902 *cpu);
-static inline void AND_r(struct lr35902 *cpu, uint8_t *r);
-static inline void AND_n(struct lr35902 *cpu);
-static inline void AND_cHL(struct lr35902 *cpu);
-static inline void XOR_r(struct lr35902 *cpu, uint8_t *r);
-static inline void XOR_n(struct lr35902 *cpu);
-static inline void XOR_cHL(struct lr35902 *cpu);
-static inline void OR_r(struct lr35902 *cpu, uint8_t *r);
-static inline void OR_n(struct lr35902 *cpu);
-static inline void OR_cHL(struct lr35902 *cpu);
-static inline void CP_r(struct lr35902 *cpu, uint8_t *r);
-static inline void CP_n(struct lr35902 *cpu);
-static inline void CP_cHL(struct lr35902 *cpu);
 static inline void INC_r(struct lr35902 *cpu, uint8_t *r);
 static inline void INC_cHL(struct lr35902 *cpu);
 static inline void DEC_r(struct lr35902 *cpu, uint8_t *r);
@@ -124,28 +323,6 @@ static inline void RLCA(struct lr35902 *cpu);
 static inline void RLA(struct lr35902 *cpu);
 static inline void RRCA(struct lr35902 *cpu);
 static inline void RRA(struct lr35902 *cpu);
-static inline void RLC_r(struct lr35902 *cpu, uint8_t *r);
-static inline void RLC_cHL(struct lr35902 *cpu);
-static inline void RL_r(struct lr35902 *cpu, uint8_t *r);
-static inline void RL_cHL(struct lr35902 *cpu);
-static inline void RRC_r(struct lr35902 *cpu, uint8_t *r);
-static inline void RRC_cHL(struct lr35902 *cpu);
-static inline void RR_r(struct lr35902 *cpu, uint8_t *r);
-static inline void RR_cHL(struct lr35902 *cpu);
-static inline void SWAP_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SWAP_cHL(struct lr35902 *cpu);
-static inline void SRA_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SRA_cHL(struct lr35902 *cpu);
-static inline void SLA_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SLA_cHL(struct lr35902 *cpu);
-static inline void SRL_r(struct lr35902 *cpu, uint8_t *r);
-static inline void SRL_cHL(struct lr35902 *cpu);
-static inline void BIT_n_r(struct lr35902 *cpu, uint8_t n, uint8_t *r);
-static inline void BIT_n_cHL(struct lr35902 *cpu, uint8_t n);
-static inline void SET_n_r(struct lr35902 *cpu, uint8_t n, uint8_t *r);
-static inline void SET_n_cHL(struct lr35902 *cpu, uint8_t n);
-static inline void RES_n_r(struct lr35902 *cpu, uint8_t n, uint8_t *r);
-static inline void RES_n_cHL(struct lr35902 *cpu, uint8_t n);
 static inline void CCF(struct lr35902 *cpu);
 static inline void SCF(struct lr35902 *cpu);
 static inline void NOP(struct lr35902 *cpu);
@@ -180,6 +357,26 @@ static inline void RET_NC(struct lr35902 *cpu);
 static inline void RET_C(struct lr35902 *cpu);
 static inline void RETI(struct lr35902 *cpu);
 static inline void RST_n(struct lr35902 *cpu, uint8_t n);
+static inline void UNK(struct lr35902 *cpu);
+
+#ifdef CONFIG_CPU_LR35902_JIT
+/* Command-line parameter */
+static char *jit_mode_name;
+PARAM(jit_mode_name, string, "lr35902-jit", NULL,
+	"Selects LR35902 JIT mode (off or on)")
+#endif
+
+/* Shift and rotate operations of CB opcodes (indexed by bit field) */
+static uint8_t (*const cb_shifts[])(struct lr35902 *cpu, uint8_t b) = {
+	RLC,
+	RRC,
+	RL,
+	RR,
+	SLA,
+	SRA,
+	SWAP,
+	SRL
+};
 
 void LD_r_r(struct lr35902 *UNUSED(cpu), uint8_t *r1, uint8_t *r2)
 {
@@ -346,305 +543,131 @@ void LD_cnn_SP(struct lr35902 *cpu)
 	clock_consume(20);
 }
 
-void ADD_A_r(struct lr35902 *cpu, uint8_t *r)
-{
-	uint16_t result = cpu->A + *r;
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) + (*r & 0x0F) > 0x0F);
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(4);
-}
-
-void ADD_A_n(struct lr35902 *cpu)
-{
-	uint8_t n = memory_readb(cpu->bus_id, cpu->PC++);
-	uint16_t result = cpu->A + n;
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) + (n & 0x0F) > 0x0F);
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(8);
-}
-
-void ADD_A_cHL(struct lr35902 *cpu)
-{
-	uint16_t result = cpu->A + memory_readb(cpu->bus_id, cpu->HL);
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) +
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x0F) > 0x0F);
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(8);
-}
-
-void ADC_A_r(struct lr35902 *cpu, uint8_t *r)
-{
-	uint16_t result = cpu->A + *r + cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) + (*r & 0x0F) + cpu->flags.C > 0x0F);
-	cpu->flags.C = result >> 8;
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(4);
-}
-
-void ADC_A_n(struct lr35902 *cpu)
+void ADD(struct lr35902 *cpu, uint8_t b)
 {
-	uint8_t n = memory_readb(cpu->bus_id, cpu->PC++);
-	uint16_t result = cpu->A + n + cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) + (n & 0x0F) + cpu->flags.C > 0x0F);
+	uint16_t result = cpu->A + b;
 	cpu->flags.C = result >> 8;
+	cpu->flags.H = ((cpu->A & 0x0F) + (b & 0x0F) > 0x0F);
 	cpu->flags.N = 0;
 	cpu->flags.Z = ((uint8_t)result == 0);
 	cpu->A = result;
 }
 
-void ADC_A_cHL(struct lr35902 *cpu)
+void ADC(struct lr35902 *cpu, uint8_t b)
 {
-	uint16_t result = cpu->A + memory_readb(cpu->bus_id, cpu->HL) +
-		cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) +
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x0F) +
-		cpu->flags.C > 0x0F);
+	uint16_t result = cpu->A + b + cpu->flags.C;
+	cpu->flags.H = ((cpu->A & 0x0F) + (b & 0x0F) + cpu->flags.C > 0x0F);
 	cpu->flags.C = result >> 8;
 	cpu->flags.N = 0;
 	cpu->flags.Z = ((uint8_t)result == 0);
 	cpu->A = result;
-	clock_consume(8);
-}
-
-void SUB_A_r(struct lr35902 *cpu, uint8_t *r)
-{
-	int16_t result = cpu->A - *r;
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) - (*r & 0x0F) < 0);
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(4);
-}
-
-void SUB_A_n(struct lr35902 *cpu)
-{
-	uint8_t n = memory_readb(cpu->bus_id, cpu->PC++);
-	int16_t result = cpu->A - n;
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) - (n & 0x0F) < 0);
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(8);
-}
-
-void SUB_A_cHL(struct lr35902 *cpu)
-{
-	int16_t result = cpu->A - memory_readb(cpu->bus_id, cpu->HL);
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) -
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x0F) < 0);
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(8);
-}
-
-void SBC_A_r(struct lr35902 *cpu, uint8_t *r)
-{
-	int16_t result = cpu->A - *r - cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) - (*r & 0x0F) - cpu->flags.C < 0);
-	cpu->flags.C = result >> 8;
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	cpu->A = result;
-	clock_consume(4);
 }
 
-void SBC_A_n(struct lr35902 *cpu)
+void SUB(struct lr35902 *cpu, uint8_t b)
 {
-	uint8_t n = memory_readb(cpu->bus_id, cpu->PC++);
-	int16_t result = cpu->A - n - cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) - (n & 0x0F) - cpu->flags.C < 0);
+	int16_t result = cpu->A - b;
 	cpu->flags.C = result >> 8;
+	cpu->flags.H = ((cpu->A & 0x0F) - (b & 0x0F) < 0);
 	cpu->flags.N = 1;
 	cpu->flags.Z = ((uint8_t)result == 0);
 	cpu->A = result;
-	clock_consume(8);
 }
 
-void SBC_A_cHL(struct lr35902 *cpu)
+void SBC(struct lr35902 *cpu, uint8_t b)
 {
-	int16_t result = cpu->A - memory_readb(cpu->bus_id, cpu->HL) -
-		cpu->flags.C;
-	cpu->flags.H = ((cpu->A & 0x0F) -
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x0F) - cpu->flags.C < 0);
+	int16_t result = cpu->A - b - cpu->flags.C;
+	cpu->flags.H = ((cpu->A & 0x0F) - (b & 0x0F) - cpu->flags.C < 0);
 	cpu->flags.C = result >> 8;
 	cpu->flags.N = 1;
 	cpu->flags.Z = ((uint8_t)result == 0);
 	cpu->A = result;
-	clock_consume(8);
-}
-
-void AND_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->A &= *r;
-	cpu->flags.C = 0;
-	cpu->flags.H = 1;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(4);
-}
-
-void AND_n(struct lr35902 *cpu)
-{
-	cpu->A &= memory_readb(cpu->bus_id, cpu->PC++);
-	cpu->flags.C = 0;
-	cpu->flags.H = 1;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
 }
 
-void AND_cHL(struct lr35902 *cpu)
+void AND(struct lr35902 *cpu, uint8_t b)
 {
-	cpu->A &= memory_readb(cpu->bus_id, cpu->HL);
+	cpu->A &= b;
 	cpu->flags.C = 0;
 	cpu->flags.H = 1;
 	cpu->flags.N = 0;
 	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
-}
-
-void XOR_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->A ^= *r;
-	cpu->flags.C = 0;
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(4);
-}
-
-void XOR_n(struct lr35902 *cpu)
-{
-	cpu->A ^= memory_readb(cpu->bus_id, cpu->PC++);
-	cpu->flags.C = 0;
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
-}
-
-void XOR_cHL(struct lr35902 *cpu)
-{
-	cpu->A ^= memory_readb(cpu->bus_id, cpu->HL);
-	cpu->flags.C = 0;
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
-}
-
-void OR_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->A |= *r;
-	cpu->flags.C = 0;
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(4);
 }
 
-void OR_n(struct lr35902 *cpu)
+void XOR(struct lr35902 *cpu, uint8_t b)
 {
-	cpu->A |= memory_readb(cpu->bus_id, cpu->PC++);
+	cpu->A ^= b;
 	cpu->flags.C = 0;
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
 	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
 }
 
-void OR_cHL(struct lr35902 *cpu)
+void OR(struct lr35902 *cpu, uint8_t b)
 {
-	cpu->A |= memory_readb(cpu->bus_id, cpu->HL);
+	cpu->A |= b;
 	cpu->flags.C = 0;
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
 	cpu->flags.Z = (cpu->A == 0);
-	clock_consume(8);
 }
 
-void CP_r(struct lr35902 *cpu, uint8_t *r)
+void CP(struct lr35902 *cpu, uint8_t b)
 {
-	int16_t result = cpu->A - *r;
+	int16_t result = cpu->A - b;
 	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) - (*r & 0x0F) < 0);
+	cpu->flags.H = ((cpu->A & 0x0F) - (b & 0x0F) < 0);
 	cpu->flags.N = 1;
 	cpu->flags.Z = ((uint8_t)result == 0);
-	clock_consume(4);
 }
 
-void CP_n(struct lr35902 *cpu)
-{
-	uint8_t n = memory_readb(cpu->bus_id, cpu->PC++);
-	int16_t result = cpu->A - n;
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) - (n & 0x0F) < 0);
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	clock_consume(8);
-}
+ALU_INSTRUCTION(ADD_A, ADD)
+ALU_INSTRUCTION(ADC_A, ADC)
+ALU_INSTRUCTION(SUB_A, SUB)
+ALU_INSTRUCTION(SBC_A, SBC)
+ALU_INSTRUCTION(AND, AND)
+ALU_INSTRUCTION(XOR, XOR)
+ALU_INSTRUCTION(OR, OR)
+ALU_INSTRUCTION(CP, CP)
 
-void CP_cHL(struct lr35902 *cpu)
+uint8_t INC(struct lr35902 *cpu, uint8_t b)
 {
-	int16_t result = cpu->A - memory_readb(cpu->bus_id, cpu->HL);
-	cpu->flags.C = result >> 8;
-	cpu->flags.H = ((cpu->A & 0x0F) -
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x0F) < 0);
-	cpu->flags.N = 1;
-	cpu->flags.Z = ((uint8_t)result == 0);
-	clock_consume(8);
+	cpu->flags.H = ((b & 0x0F) == 0x0F);
+	cpu->flags.N = 0;
+	cpu->flags.Z = (b == 0xFF);
+	return b + 1;
 }
 
 void INC_r(struct lr35902 *cpu, uint8_t *r)
 {
-	cpu->flags.H = ((*r & 0x0F) == 0x0F);
-	cpu->flags.N = 0;
-	cpu->flags.Z = (*r == 0xFF);
-	(*r)++;
+	*r = INC(cpu, *r);
 	clock_consume(4);
 }
 
 void INC_cHL(struct lr35902 *cpu)
 {
-	cpu->flags.H = ((memory_readb(cpu->bus_id, cpu->HL) & 0x0F) == 0x0F);
-	cpu->flags.N = 0;
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0xFF);
-	memory_writeb(cpu->bus_id, memory_readb(cpu->bus_id, cpu->HL) + 1,
-		cpu->HL);
+	uint8_t b = memory_readb(cpu->bus_id, cpu->HL);
+	memory_writeb(cpu->bus_id, INC(cpu, b), cpu->HL);
 	clock_consume(12);
 }
 
-void DEC_r(struct lr35902 *cpu, uint8_t *r)
+uint8_t DEC(struct lr35902 *cpu, uint8_t b)
 {
-	(*r)--;
-	cpu->flags.H = ((*r & 0x0F) == 0x0F);
+	b--;
+	cpu->flags.H = ((b & 0x0F) == 0x0F);
 	cpu->flags.N = 1;
-	cpu->flags.Z = (*r == 0);
+	cpu->flags.Z = (b == 0);
+	return b;
+}
+
+void DEC_r(struct lr35902 *cpu, uint8_t *r)
+{
+	*r = DEC(cpu, *r);
 	clock_consume(4);
 }
 
 void DEC_cHL(struct lr35902 *cpu)
 {
-	memory_writeb(cpu->bus_id, memory_readb(cpu->bus_id, cpu->HL) - 1,
-		cpu->HL);
-	cpu->flags.H = ((memory_readb(cpu->bus_id, cpu->HL) & 0x0F) == 0x0F);
-	cpu->flags.N = 1;
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
+	uint8_t b = memory_readb(cpu->bus_id, cpu->HL);
+	memory_writeb(cpu->bus_id, DEC(cpu, b), cpu->HL);
 	clock_consume(12);
 }
 
@@ -721,268 +744,112 @@ void LD_HL_SPpd(struct lr35902 *cpu)
 
 void RLCA(struct lr35902 *cpu)
 {
-	cpu->flags.C = ((cpu->A & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
+	cpu->A = RLC(cpu, cpu->A);
 	cpu->flags.Z = 0;
-	cpu->A = (cpu->A << 1) | cpu->flags.C;
 	clock_consume(4);
 }
 
 void RLA(struct lr35902 *cpu)
 {
-	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((cpu->A & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
+	cpu->A = RL(cpu, cpu->A);
 	cpu->flags.Z = 0;
-	cpu->A = (cpu->A << 1) | old_carry;
 	clock_consume(4);
 }
 
 void RRCA(struct lr35902 *cpu)
 {
-	cpu->flags.C = ((cpu->A & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
+	cpu->A = RRC(cpu, cpu->A);
 	cpu->flags.Z = 0;
-	cpu->A = (cpu->A >> 1) | (cpu->flags.C << 7);
 	clock_consume(4);
 }
 
 void RRA(struct lr35902 *cpu)
 {
-	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((cpu->A & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
+	cpu->A = RR(cpu, cpu->A);
 	cpu->flags.Z = 0;
-	cpu->A = (cpu->A >> 1) | (old_carry << 7);
 	clock_consume(4);
 }
 
-void RLC_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->flags.C = ((*r & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (*r == 0);
-	*r = (*r << 1) | cpu->flags.C;
-	clock_consume(8);
-}
-
-void RLC_cHL(struct lr35902 *cpu)
+uint8_t RLC(struct lr35902 *cpu, uint8_t b)
 {
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x80) != 0);
+	cpu->flags.C = ((b & 0x80) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) << 1) | cpu->flags.C,
-		cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
+	b = (b << 1) | cpu->flags.C;
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void RL_r(struct lr35902 *cpu, uint8_t *r)
+uint8_t RRC(struct lr35902 *cpu, uint8_t b)
 {
-	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((*r & 0x80) != 0);
+	cpu->flags.C = ((b & 0x01) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	*r = (*r << 1) | old_carry;
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
+	b = (b >> 1) | (cpu->flags.C << 7);
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void RL_cHL(struct lr35902 *cpu)
+uint8_t RL(struct lr35902 *cpu, uint8_t b)
 {
 	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) << 1) | old_carry,
-		cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
-}
-
-void RRC_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->flags.C = ((*r & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	cpu->flags.Z = (*r == 0);
-	*r = (*r >> 1) | (cpu->flags.C << 7);
-	clock_consume(8);
-}
-
-void RRC_cHL(struct lr35902 *cpu)
-{
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x01) != 0);
+	cpu->flags.C = ((b & 0x80) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) >> 1) | (cpu->flags.C << 7),
-		cpu->HL);
-	clock_consume(16);
+	b = (b << 1) | old_carry;
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void RR_r(struct lr35902 *cpu, uint8_t *r)
+uint8_t RR(struct lr35902 *cpu, uint8_t b)
 {
 	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((*r & 0x01) != 0);
+	cpu->flags.C = ((b & 0x01) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	*r = (*r >> 1) | (old_carry << 7);
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
+	b = (b >> 1) | (old_carry << 7);
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void RR_cHL(struct lr35902 *cpu)
+uint8_t SLA(struct lr35902 *cpu, uint8_t b)
 {
-	int old_carry = cpu->flags.C;
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x01) != 0);
+	cpu->flags.C = ((b & 0x80) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) >> 1) | (old_carry << 7),
-		cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
+	b <<= 1;
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void SWAP_r(struct lr35902 *cpu, uint8_t *r)
+uint8_t SRA(struct lr35902 *cpu, uint8_t b)
 {
-	*r = (*r << 4) | (*r >> 4);
-	cpu->flags.C = 0;
+	cpu->flags.C = ((b & 0x01) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
+	b = (b >> 1) | (b & 0x80);
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void SWAP_cHL(struct lr35902 *cpu)
+uint8_t SWAP(struct lr35902 *cpu, uint8_t b)
 {
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) << 4) |
-		(memory_readb(cpu->bus_id, cpu->HL) >> 4),
-		cpu->HL);
+	b = (b << 4) | (b >> 4);
 	cpu->flags.C = 0;
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
-}
-
-void SRA_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->flags.C = ((*r & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	*r = (*r >> 1) | (*r & 0x80);
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
-}
-
-void SRA_cHL(struct lr35902 *cpu)
-{
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id,
-		(memory_readb(cpu->bus_id, cpu->HL) >> 1) |
-		(memory_readb(cpu->bus_id, cpu->HL) & 0x80),
-		cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
-}
-
-void SLA_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->flags.C = ((*r & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	*r <<= 1;
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
-}
-
-void SLA_cHL(struct lr35902 *cpu)
-{
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x80) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id, memory_readb(cpu->bus_id, cpu->HL) << 1,
-		cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
-}
-
-void SRL_r(struct lr35902 *cpu, uint8_t *r)
-{
-	cpu->flags.C = ((*r & 0x01) != 0);
-	cpu->flags.H = 0;
-	cpu->flags.N = 0;
-	*r >>= 1;
-	cpu->flags.Z = (*r == 0);
-	clock_consume(8);
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
-void SRL_cHL(struct lr35902 *cpu)
+uint8_t SRL(struct lr35902 *cpu, uint8_t b)
 {
-	cpu->flags.C = ((memory_readb(cpu->bus_id, cpu->HL) & 0x01) != 0);
+	cpu->flags.C = ((b & 0x01) != 0);
 	cpu->flags.H = 0;
 	cpu->flags.N = 0;
-	memory_writeb(cpu->bus_id, memory_readb(cpu->bus_id, cpu->HL) >> 1,
-		 cpu->HL);
-	cpu->flags.Z = (memory_readb(cpu->bus_id, cpu->HL) == 0);
-	clock_consume(16);
-}
-
-void BIT_n_r(struct lr35902 *cpu, uint8_t n, uint8_t *r)
-{
-	cpu->flags.H = 1;
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((*r & (1 << n)) == 0);
-	clock_consume(8);
-}
-
-void BIT_n_cHL(struct lr35902 *cpu, uint8_t n)
-{
-	cpu->flags.H = 1;
-	cpu->flags.N = 0;
-	cpu->flags.Z = ((memory_readb(cpu->bus_id, cpu->HL) & (1 << n)) == 0);
-	clock_consume(12);
-}
-
-void SET_n_r(struct lr35902 *UNUSED(cpu), uint8_t n, uint8_t *r)
-{
-	*r |= (1 << n);
-	clock_consume(8);
-}
-
-void SET_n_cHL(struct lr35902 *cpu, uint8_t n)
-{
-	memory_writeb(cpu->bus_id,
-		memory_readb(cpu->bus_id, cpu->HL) | (1 << n),
-		cpu->HL);
-	clock_consume(16);
-}
-
-void RES_n_r(struct lr35902 *UNUSED(cpu), uint8_t n, uint8_t *r)
-{
-	*r &= ~(1 << n);
-	clock_consume(8);
-}
-
-void RES_n_cHL(struct lr35902 *cpu, uint8_t n)
-{
-	memory_writeb(cpu->bus_id,
-		memory_readb(cpu->bus_id, cpu->HL) & ~(1 << n),
-		cpu->HL);
-	clock_consume(16);
+	b >>= 1;
+	cpu->flags.Z = (b == 0);
+	return b;
 }
 
 void CCF(struct lr35902 *cpu)
@@ -1209,21 +1076,84 @@ void RST_n(struct lr35902 *cpu, uint8_t n)
 	clock_consume(16);
 }
 
-bool lr35902_handle_interrupts(struct lr35902 *cpu)
+void UNK(struct lr35902 *cpu)
 {
-	int irq;
+	uint8_t opcode = memory_readb(cpu->bus_id, cpu->PC - 1);
+	LOG_W("lr35902: unknown opcode (%02x)!\n", opcode);
+	clock_consume(1);
+}
 
-	/* Check if interrupts are enabled */
+void lr35902_opcode_CB(struct lr35902 *cpu)
+{
+	uint8_t opcode;
+	uint8_t bit;
+	uint8_t *r;
+	uint8_t b;
+
+	/* Fetch CB opcode and decode its fields */
+	opcode = memory_fetchb(cpu->bus_id, cpu->PC++);
+	bit = CB_BIT(opcode);
+	r = cpu->regs[CB_REGISTER(opcode)];
+
+	/* Get operand from register or memory at HL */
+	b = r ? *r : memory_readb(cpu->bus_id, cpu->HL);
+
+	/* Execute operation (bit tests do not write operand back) */
+	switch (CB_OPERATION(opcode)) {
+	case CB_SHIFT:
+		b = cb_shifts[bit](cpu, b);
+		break;
+	case CB_TEST:
+		cpu->flags.H = 1;
+		cpu->flags.N = 0;
+		cpu->flags.Z = ((b & BIT(bit)) == 0);
+		clock_consume(r ? 8 : 12);
+		return;
+	case CB_RES:
+		b &= ~BIT(bit);
+		break;
+	case CB_SET:
+		b |= BIT(bit);
+		break;
+	}
+
+	/* Write operand back */
+	if (r) {
+		*r = b;
+		clock_consume(8);
+	} else {
+		memory_writeb(cpu->bus_id, b, cpu->HL);
+		clock_consume(16);
+	}
+}
+
+int lr35902_get_interrupt(struct lr35902 *cpu)
+{
+	int irq;
+
+	/* Check if interrupts are enabled */
 	if (!cpu->IME)
-		return false;
+		return -1;
 
 	/* Get interrupt request (by priority) and leave if none is active */
 	irq = bitops_ffs(cpu->IF);
 	if (irq-- == 0)
-		return false;
+		return -1;
 
 	/* Check if particular interrupt is enabled */
 	if (!(cpu->IE & BIT(irq)))
+		return -1;
+
+	return irq;
+}
+
+bool lr35902_handle_interrupts(struct lr35902 *cpu)
+{
+	int irq;
+
+	/* Leave if no enabled interrupt is requested */
+	irq = lr35902_get_interrupt(cpu);
+	if (irq < 0)
 		return false;
 
 	/* Clear master interrupt enable flag */
@@ -1244,9 +1174,75 @@ bool lr35902_handle_interrupts(struct lr35902 *cpu)
 	return true;
 }
 
+#ifdef CONFIG_CPU_LR35902_THREADED
+
+/* Handler label generation (each handler jumps straight to the next one) */
+#define OPCODE_LABEL(opcode, handler, ...) \
+	[opcode] = &&op_##opcode,
+#define OPCODE_BLOCK(opcode, handler, ...) \
+	op_##opcode: \
+		handler(cpu, ##__VA_ARGS__); \
+		DISPATCH();
+
+/* Run next instruction unless another clock is due (interrupt requests and
+halted state are checked out of line) */
+#define DISPATCH() \
+	do { \
+		if (!clock_run_ahead()) \
+			return; \
+		if ((cpu->IME && cpu->IF) || cpu->halted) \
+			goto check; \
+		goto *labels[memory_fetchb(cpu->bus_id, cpu->PC++)]; \
+	} while (0)
+
 void lr35902_tick(clock_data_t *data)
 {
+	static void *const labels[256] = { LR35902_OPCODES(OPCODE_LABEL) };
 	struct lr35902 *cpu = data;
+
+	goto check;
+
+	/* Opcode handlers */
+	LR35902_OPCODES(OPCODE_BLOCK)
+
+check:
+	/* Check for interrupt requests */
+	if (lr35902_handle_interrupts(cpu))
+		DISPATCH();
+
+	/* Check if CPU is halted */
+	if (cpu->halted) {
+		clock_consume(1);
+		DISPATCH();
+	}
+
+	/* Fetch and execute opcode */
+	goto *labels[memory_fetchb(cpu->bus_id, cpu->PC++)];
+}
+
+#endif
+
+#if !defined(CONFIG_CPU_LR35902_THREADED) || defined(CONFIG_CPU_LR35902_JIT)
+
+/* Opcode handler generation and table */
+#define OPCODE_FUNCTION(opcode, handler, ...) \
+	static void lr35902_op_##opcode(struct lr35902 *cpu) \
+	{ \
+		handler(cpu, ##__VA_ARGS__); \
+	}
+#define OPCODE_HANDLER(opcode, handler, ...) \
+	[opcode] = lr35902_op_##opcode,
+LR35902_OPCODES(OPCODE_FUNCTION)
+static void (*const lr35902_handlers[256])(struct lr35902 *cpu) = {
+	LR35902_OPCODES(OPCODE_HANDLER)
+};
+
+#endif
+
+#ifndef CONFIG_CPU_LR35902_THREADED
+
+void lr35902_step(struct lr35902 *cpu)
+{
 	uint8_t opcode;
 
 	/* Check for interrupt requests */
@@ -1259,1537 +1255,363 @@ void lr35902_tick(clock_data_t *data)
 		return;
 	}
 
-	/* Fetch opcode */
-	opcode = memory_readb(cpu->bus_id, cpu->PC++);
+	/* Fetch and execute opcode */
+	opcode = memory_fetchb(cpu->bus_id, cpu->PC++);
+	lr35902_handlers[opcode](cpu);
+}
+
+void lr35902_tick(clock_data_t *data)
+{
+	struct lr35902 *cpu = data;
+
+	/* Execute instructions until another clock is due */
+	do {
+		lr35902_step(cpu);
+	} while (clock_run_ahead());
+}
+
+#endif
+
+#ifdef CONFIG_CPU_LR35902_JIT
+
+/* Instruction lengths (operands are still read by opcode handlers) */
+static const uint8_t lr35902_lengths[256] = {
+	1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,	/* 0x00 */
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	/* 0x10 */
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	/* 0x20 */
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	/* 0x30 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x40 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x50 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x60 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x70 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x80 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0x90 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0xA0 */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	/* 0xB0 */
+	1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,	/* 0xC0 */
+	1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,	/* 0xD0 */
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,	/* 0xE0 */
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1	/* 0xF0 */
+};
+
+/* Longest instruction cycle counts (conditional instructions taken and
+CB-prefixed ones operating on (HL)), bounding how long blocks run between
+checks */
+static const uint8_t lr35902_cycles[256] = {
+	4, 12, 8, 8, 4, 4, 8, 4,	/* 0x00 */
+	20, 8, 8, 8, 4, 4, 8, 4,	/* 0x08 */
+	4, 12, 8, 8, 4, 4, 8, 4,	/* 0x10 */
+	12, 8, 8, 8, 4, 4, 8, 4,	/* 0x18 */
+	12, 12, 8, 8, 4, 4, 8, 4,	/* 0x20 */
+	12, 8, 8, 8, 4, 4, 8, 4,	/* 0x28 */
+	12, 12, 8, 8, 12, 12, 12, 4,	/* 0x30 */
+	12, 8, 8, 8, 4, 4, 8, 4,	/* 0x38 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x40 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x48 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x50 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x58 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x60 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x68 */
+	8, 8, 8, 8, 8, 8, 4, 8,		/* 0x70 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x78 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x80 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x88 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x90 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0x98 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0xA0 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0xA8 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0xB0 */
+	4, 4, 4, 4, 4, 4, 8, 4,		/* 0xB8 */
+	20, 12, 16, 16, 24, 16, 8, 16,	/* 0xC0 */
+	20, 16, 16, 16, 24, 24, 8, 16,	/* 0xC8 */
+	20, 12, 16, 1, 24, 16, 8, 16,	/* 0xD0 */
+	20, 16, 16, 1, 24, 1, 8, 16,	/* 0xD8 */
+	12, 12, 8, 1, 1, 16, 8, 16,	/* 0xE0 */
+	16, 4, 16, 1, 1, 1, 8, 16,	/* 0xE8 */
+	12, 24, 8, 4, 1, 16, 8, 16,	/* 0xF0 */
+	12, 8, 16, 4, 1, 1, 8, 16	/* 0xF8 */
+};
+
+bool lr35902_jit_decode(struct bus *bus, uint16_t address, uint8_t *opcode)
+{
+	struct page *page;
+
+	/* Only opcodes located in plain read-only memory (such as ROM banks)
+	can be translated */
+	page = memory_bus_page(bus, address & bus->mask);
+	if (!page->read_mem || page->write_mem)
+		return false;
+
+	/* Peek at opcode (without affecting the data bus) */
+	*opcode = page->read_mem[address & BUS_PAGE_MASK];
+	return true;
+}
 
-	/* Execute opcode */
+bool lr35902_jit_ends_block(uint8_t opcode)
+{
+	/* Jumps, calls, returns, restarts, HALT and STOP change PC or stop
+	execution */
 	switch (opcode) {
-	case 0x00:
-		NOP(cpu);
-		break;
-	case 0x01:
-		LD_rr_nn(cpu, &cpu->BC);
-		break;
-	case 0x02:
-		LD_cBC_A(cpu);
-		break;
-	case 0x03:
-		INC_rr(cpu, &cpu->BC);
-		break;
-	case 0x04:
-		INC_r(cpu, &cpu->B);
-		break;
-	case 0x05:
-		DEC_r(cpu, &cpu->B);
-		break;
-	case 0x06:
-		LD_r_n(cpu, &cpu->B);
-		break;
-	case 0x07:
-		RLCA(cpu);
-		break;
-	case 0x08:
-		LD_cnn_SP(cpu);
-		break;
-	case 0x09:
-		ADD_HL_rr(cpu, &cpu->BC);
-		break;
-	case 0x0A:
-		LD_A_cBC(cpu);
-		break;
-	case 0x0B:
-		DEC_rr(cpu, &cpu->BC);
-		break;
-	case 0x0C:
-		INC_r(cpu, &cpu->C);
-		break;
-	case 0x0D:
-		DEC_r(cpu, &cpu->C);
-		break;
-	case 0x0E:
-		LD_r_n(cpu, &cpu->C);
-		break;
-	case 0x0F:
-		RRCA(cpu);
-		break;
 	case 0x10:
-		STOP(cpu);
-		break;
-	case 0x11:
-		LD_rr_nn(cpu, &cpu->DE);
-		break;
-	case 0x12:
-		LD_cDE_A(cpu);
-		break;
-	case 0x13:
-		INC_rr(cpu, &cpu->DE);
-		break;
-	case 0x14:
-		INC_r(cpu, &cpu->D);
-		break;
-	case 0x15:
-		DEC_r(cpu, &cpu->D);
-		break;
-	case 0x16:
-		LD_r_n(cpu, &cpu->D);
-		break;
-	case 0x17:
-		RLA(cpu);
-		break;
 	case 0x18:
-		JR_d(cpu);
-		break;
-	case 0x19:
-		ADD_HL_rr(cpu, &cpu->DE);
-		break;
-	case 0x1A:
-		LD_A_cDE(cpu);
-		break;
-	case 0x1B:
-		DEC_rr(cpu, &cpu->DE);
-		break;
-	case 0x1C:
-		INC_r(cpu, &cpu->E);
-		break;
-	case 0x1D:
-		DEC_r(cpu, &cpu->E);
-		break;
-	case 0x1E:
-		LD_r_n(cpu, &cpu->E);
-		break;
-	case 0x1F:
-		RRA(cpu);
-		break;
-	case 0x20:
-		JR_NZ_d(cpu);
-		break;
-	case 0x21:
-		LD_rr_nn(cpu, &cpu->HL);
-		break;
-	case 0x22:
-		LDI_cHL_A(cpu);
-		break;
-	case 0x23:
-		INC_rr(cpu, &cpu->HL);
-		break;
-	case 0x24:
-		INC_r(cpu, &cpu->H);
-		break;
-	case 0x25:
-		DEC_r(cpu, &cpu->H);
-		break;
-	case 0x26:
-		LD_r_n(cpu, &cpu->H);
-		break;
-	case 0x27:
-		DAA(cpu);
-		break;
-	case 0x28:
-		JR_Z_d(cpu);
-		break;
-	case 0x29:
-		ADD_HL_rr(cpu, &cpu->HL);
-		break;
-	case 0x2A:
-		LDI_A_cHL(cpu);
-		break;
-	case 0x2B:
-		DEC_rr(cpu, &cpu->HL);
-		break;
-	case 0x2C:
-		INC_r(cpu, &cpu->L);
-		break;
-	case 0x2D:
-		DEC_r(cpu, &cpu->L);
-		break;
-	case 0x2E:
-		LD_r_n(cpu, &cpu->L);
-		break;
-	case 0x2F:
-		CPL(cpu);
-		break;
-	case 0x30:
-		JR_NC_d(cpu);
-		break;
-	case 0x31:
-		LD_rr_nn(cpu, &cpu->SP);
-		break;
-	case 0x32:
-		LDD_cHL_A(cpu);
-		break;
-	case 0x33:
-		INC_rr(cpu, &cpu->SP);
-		break;
-	case 0x34:
-		INC_cHL(cpu);
-		break;
-	case 0x35:
-		DEC_cHL(cpu);
-		break;
-	case 0x36:
-		LD_cHL_n(cpu);
-		break;
-	case 0x37:
-		SCF(cpu);
-		break;
-	case 0x38:
-		JR_C_d(cpu);
-		break;
-	case 0x39:
-		ADD_HL_rr(cpu, &cpu->SP);
-		break;
-	case 0x3A:
-		LDD_A_cHL(cpu);
-		break;
-	case 0x3B:
-		DEC_rr(cpu, &cpu->SP);
-		break;
-	case 0x3C:
-		INC_r(cpu, &cpu->A);
-		break;
-	case 0x3D:
-		DEC_r(cpu, &cpu->A);
-		break;
-	case 0x3E:
-		LD_r_n(cpu, &cpu->A);
-		break;
-	case 0x3F:
-		CCF(cpu);
-		break;
-	case 0x40:
-		LD_r_r(cpu, &cpu->B, &cpu->B);
-		break;
-	case 0x41:
-		LD_r_r(cpu, &cpu->B, &cpu->C);
-		break;
-	case 0x42:
-		LD_r_r(cpu, &cpu->B, &cpu->D);
-		break;
-	case 0x43:
-		LD_r_r(cpu, &cpu->B, &cpu->E);
-		break;
-	case 0x44:
-		LD_r_r(cpu, &cpu->B, &cpu->H);
-		break;
-	case 0x45:
-		LD_r_r(cpu, &cpu->B, &cpu->L);
-		break;
-	case 0x46:
-		LD_r_cHL(cpu, &cpu->B);
-		break;
-	case 0x47:
-		LD_r_r(cpu, &cpu->B, &cpu->A);
-		break;
-	case 0x48:
-		LD_r_r(cpu, &cpu->C, &cpu->B);
-		break;
-	case 0x49:
-		LD_r_r(cpu, &cpu->C, &cpu->C);
-		break;
-	case 0x4A:
-		LD_r_r(cpu, &cpu->C, &cpu->D);
-		break;
-	case 0x4B:
-		LD_r_r(cpu, &cpu->C, &cpu->E);
-		break;
-	case 0x4C:
-		LD_r_r(cpu, &cpu->C, &cpu->H);
-		break;
-	case 0x4D:
-		LD_r_r(cpu, &cpu->C, &cpu->L);
-		break;
-	case 0x4E:
-		LD_r_cHL(cpu, &cpu->C);
-		break;
-	case 0x4F:
-		LD_r_r(cpu, &cpu->C, &cpu->A);
-		break;
-	case 0x50:
-		LD_r_r(cpu, &cpu->D, &cpu->B);
-		break;
-	case 0x51:
-		LD_r_r(cpu, &cpu->D, &cpu->C);
-		break;
-	case 0x52:
-		LD_r_r(cpu, &cpu->D, &cpu->D);
-		break;
-	case 0x53:
-		LD_r_r(cpu, &cpu->D, &cpu->E);
-		break;
-	case 0x54:
-		LD_r_r(cpu, &cpu->D, &cpu->H);
-		break;
-	case 0x55:
-		LD_r_r(cpu, &cpu->D, &cpu->L);
-		break;
-	case 0x56:
-		LD_r_cHL(cpu, &cpu->D);
-		break;
-	case 0x57:
-		LD_r_r(cpu, &cpu->D, &cpu->A);
-		break;
-	case 0x58:
-		LD_r_r(cpu, &cpu->E, &cpu->B);
-		break;
-	case 0x59:
-		LD_r_r(cpu, &cpu->E, &cpu->C);
-		break;
-	case 0x5A:
-		LD_r_r(cpu, &cpu->E, &cpu->D);
-		break;
-	case 0x5B:
-		LD_r_r(cpu, &cpu->E, &cpu->E);
-		break;
-	case 0x5C:
-		LD_r_r(cpu, &cpu->E, &cpu->H);
-		break;
-	case 0x5D:
-		LD_r_r(cpu, &cpu->E, &cpu->L);
-		break;
-	case 0x5E:
-		LD_r_cHL(cpu, &cpu->E);
-		break;
-	case 0x5F:
-		LD_r_r(cpu, &cpu->E, &cpu->A);
-		break;
-	case 0x60:
-		LD_r_r(cpu, &cpu->H, &cpu->B);
-		break;
-	case 0x61:
-		LD_r_r(cpu, &cpu->H, &cpu->C);
-		break;
-	case 0x62:
-		LD_r_r(cpu, &cpu->H, &cpu->D);
-		break;
-	case 0x63:
-		LD_r_r(cpu, &cpu->H, &cpu->E);
-		break;
-	case 0x64:
-		LD_r_r(cpu, &cpu->H, &cpu->H);
-		break;
-	case 0x65:
-		LD_r_r(cpu, &cpu->H, &cpu->L);
-		break;
-	case 0x66:
-		LD_r_cHL(cpu, &cpu->H);
-		break;
-	case 0x67:
-		LD_r_r(cpu, &cpu->H, &cpu->A);
-		break;
-	case 0x68:
-		LD_r_r(cpu, &cpu->L, &cpu->B);
-		break;
-	case 0x69:
-		LD_r_r(cpu, &cpu->L, &cpu->C);
-		break;
-	case 0x6A:
-		LD_r_r(cpu, &cpu->L, &cpu->D);
-		break;
-	case 0x6B:
-		LD_r_r(cpu, &cpu->L, &cpu->E);
-		break;
-	case 0x6C:
-		LD_r_r(cpu, &cpu->L, &cpu->H);
-		break;
-	case 0x6D:
-		LD_r_r(cpu, &cpu->L, &cpu->L);
-		break;
-	case 0x6E:
-		LD_r_cHL(cpu, &cpu->L);
-		break;
-	case 0x6F:
-		LD_r_r(cpu, &cpu->L, &cpu->A);
-		break;
-	case 0x70:
-		LD_cHL_r(cpu, &cpu->B);
-		break;
-	case 0x71:
-		LD_cHL_r(cpu, &cpu->C);
-		break;
-	case 0x72:
-		LD_cHL_r(cpu, &cpu->D);
-		break;
-	case 0x73:
-		LD_cHL_r(cpu, &cpu->E);
-		break;
-	case 0x74:
-		LD_cHL_r(cpu, &cpu->H);
-		break;
-	case 0x75:
-		LD_cHL_r(cpu, &cpu->L);
-		break;
 	case 0x76:
-		HALT(cpu);
-		break;
-	case 0x77:
-		LD_cHL_r(cpu, &cpu->A);
-		break;
-	case 0x78:
-		LD_r_r(cpu, &cpu->A, &cpu->B);
-		break;
-	case 0x79:
-		LD_r_r(cpu, &cpu->A, &cpu->C);
-		break;
-	case 0x7A:
-		LD_r_r(cpu, &cpu->A, &cpu->D);
-		break;
-	case 0x7B:
-		LD_r_r(cpu, &cpu->A, &cpu->E);
-		break;
-	case 0x7C:
-		LD_r_r(cpu, &cpu->A, &cpu->H);
-		break;
-	case 0x7D:
-		LD_r_r(cpu, &cpu->A, &cpu->L);
-		break;
-	case 0x7E:
-		LD_r_cHL(cpu, &cpu->A);
-		break;
-	case 0x7F:
-		LD_r_r(cpu, &cpu->A, &cpu->A);
-		break;
-	case 0x80:
-		ADD_A_r(cpu, &cpu->B);
-		break;
-	case 0x81:
-		ADD_A_r(cpu, &cpu->C);
-		break;
-	case 0x82:
-		ADD_A_r(cpu, &cpu->D);
-		break;
-	case 0x83:
-		ADD_A_r(cpu, &cpu->E);
-		break;
-	case 0x84:
-		ADD_A_r(cpu, &cpu->H);
-		break;
-	case 0x85:
-		ADD_A_r(cpu, &cpu->L);
-		break;
-	case 0x86:
-		ADD_A_cHL(cpu);
-		break;
-	case 0x87:
-		ADD_A_r(cpu, &cpu->A);
-		break;
-	case 0x88:
-		ADC_A_r(cpu, &cpu->B);
-		break;
-	case 0x89:
-		ADC_A_r(cpu, &cpu->C);
-		break;
-	case 0x8A:
-		ADC_A_r(cpu, &cpu->D);
-		break;
-	case 0x8B:
-		ADC_A_r(cpu, &cpu->E);
-		break;
-	case 0x8C:
-		ADC_A_r(cpu, &cpu->H);
-		break;
-	case 0x8D:
-		ADC_A_r(cpu, &cpu->L);
-		break;
-	case 0x8E:
-		ADC_A_cHL(cpu);
-		break;
-	case 0x8F:
-		ADC_A_r(cpu, &cpu->A);
-		break;
-	case 0x90:
-		SUB_A_r(cpu, &cpu->B);
-		break;
-	case 0x91:
-		SUB_A_r(cpu, &cpu->C);
-		break;
-	case 0x92:
-		SUB_A_r(cpu, &cpu->D);
-		break;
-	case 0x93:
-		SUB_A_r(cpu, &cpu->E);
-		break;
-	case 0x94:
-		SUB_A_r(cpu, &cpu->H);
-		break;
-	case 0x95:
-		SUB_A_r(cpu, &cpu->L);
-		break;
-	case 0x96:
-		SUB_A_cHL(cpu);
-		break;
-	case 0x97:
-		SUB_A_r(cpu, &cpu->A);
-		break;
-	case 0x98:
-		SBC_A_r(cpu, &cpu->B);
-		break;
-	case 0x99:
-		SBC_A_r(cpu, &cpu->C);
-		break;
-	case 0x9A:
-		SBC_A_r(cpu, &cpu->D);
-		break;
-	case 0x9B:
-		SBC_A_r(cpu, &cpu->E);
-		break;
-	case 0x9C:
-		SBC_A_r(cpu, &cpu->H);
-		break;
-	case 0x9D:
-		SBC_A_r(cpu, &cpu->L);
-		break;
-	case 0x9E:
-		SBC_A_cHL(cpu);
-		break;
-	case 0x9F:
-		SBC_A_r(cpu, &cpu->A);
-		break;
-	case 0xA0:
-		AND_r(cpu, &cpu->B);
-		break;
-	case 0xA1:
-		AND_r(cpu, &cpu->C);
-		break;
-	case 0xA2:
-		AND_r(cpu, &cpu->D);
-		break;
-	case 0xA3:
-		AND_r(cpu, &cpu->E);
-		break;
-	case 0xA4:
-		AND_r(cpu, &cpu->H);
-		break;
-	case 0xA5:
-		AND_r(cpu, &cpu->L);
-		break;
-	case 0xA6:
-		AND_cHL(cpu);
-		break;
-	case 0xA7:
-		AND_r(cpu, &cpu->A);
-		break;
-	case 0xA8:
-		XOR_r(cpu, &cpu->B);
-		break;
-	case 0xA9:
-		XOR_r(cpu, &cpu->C);
-		break;
-	case 0xAA:
-		XOR_r(cpu, &cpu->D);
-		break;
-	case 0xAB:
-		XOR_r(cpu, &cpu->E);
-		break;
-	case 0xAC:
-		XOR_r(cpu, &cpu->H);
-		break;
-	case 0xAD:
-		XOR_r(cpu, &cpu->L);
-		break;
-	case 0xAE:
-		XOR_cHL(cpu);
-		break;
-	case 0xAF:
-		XOR_r(cpu, &cpu->A);
-		break;
-	case 0xB0:
-		OR_r(cpu, &cpu->B);
-		break;
-	case 0xB1:
-		OR_r(cpu, &cpu->C);
-		break;
-	case 0xB2:
-		OR_r(cpu, &cpu->D);
-		break;
-	case 0xB3:
-		OR_r(cpu, &cpu->E);
-		break;
-	case 0xB4:
-		OR_r(cpu, &cpu->H);
-		break;
-	case 0xB5:
-		OR_r(cpu, &cpu->L);
-		break;
-	case 0xB6:
-		OR_cHL(cpu);
-		break;
-	case 0xB7:
-		OR_r(cpu, &cpu->A);
-		break;
-	case 0xB8:
-		CP_r(cpu, &cpu->B);
-		break;
-	case 0xB9:
-		CP_r(cpu, &cpu->C);
-		break;
-	case 0xBA:
-		CP_r(cpu, &cpu->D);
-		break;
-	case 0xBB:
-		CP_r(cpu, &cpu->E);
-		break;
-	case 0xBC:
-		CP_r(cpu, &cpu->H);
-		break;
-	case 0xBD:
-		CP_r(cpu, &cpu->L);
-		break;
-	case 0xBE:
-		CP_cHL(cpu);
-		break;
-	case 0xBF:
-		CP_r(cpu, &cpu->A);
-		break;
-	case 0xC0:
-		RET_NZ(cpu);
-		break;
-	case 0xC1:
-		POP_rr(cpu, &cpu->BC);
-		break;
-	case 0xC2:
-		JP_NZ_nn(cpu);
-		break;
 	case 0xC3:
-		JP_nn(cpu);
-		break;
-	case 0xC4:
-		CALL_NZ_nn(cpu);
-		break;
-	case 0xC5:
-		PUSH_rr(cpu, &cpu->BC);
-		break;
-	case 0xC6:
-		ADD_A_n(cpu);
-		break;
-	case 0xC7:
-		RST_n(cpu, 0x00);
-		break;
-	case 0xC8:
-		RET_Z(cpu);
-		break;
 	case 0xC9:
-		RET(cpu);
-		break;
-	case 0xCA:
-		JP_Z_nn(cpu);
-		break;
-	case 0xCB:
-		lr35902_opcode_CB(cpu);
-		break;
-	case 0xCC:
-		CALL_Z_nn(cpu);
-		break;
 	case 0xCD:
-		CALL_nn(cpu);
-		break;
-	case 0xCE:
-		ADC_A_n(cpu);
-		break;
-	case 0xCF:
-		RST_n(cpu, 0x08);
-		break;
-	case 0xD0:
-		RET_NC(cpu);
-		break;
-	case 0xD1:
-		POP_rr(cpu, &cpu->DE);
-		break;
-	case 0xD2:
-		JP_NC_nn(cpu);
-		break;
-	case 0xD4:
-		CALL_NC_nn(cpu);
-		break;
-	case 0xD5:
-		PUSH_rr(cpu, &cpu->DE);
-		break;
-	case 0xD6:
-		SUB_A_n(cpu);
-		break;
-	case 0xD7:
-		RST_n(cpu, 0x10);
-		break;
-	case 0xD8:
-		RET_C(cpu);
-		break;
 	case 0xD9:
-		RETI(cpu);
-		break;
-	case 0xDA:
-		JP_C_nn(cpu);
-		break;
-	case 0xDC:
-		CALL_C_nn(cpu);
-		break;
-	case 0xDE:
-		SBC_A_n(cpu);
-		break;
-	case 0xDF:
-		RST_n(cpu, 0x18);
-		break;
-	case 0xE0:
-		LD_cFF00pn_A(cpu);
-		break;
-	case 0xE1:
-		POP_rr(cpu, &cpu->HL);
-		break;
-	case 0xE2:
-		LD_cFF00pC_A(cpu);
-		break;
-	case 0xE5:
-		PUSH_rr(cpu, &cpu->HL);
-		break;
-	case 0xE6:
-		AND_n(cpu);
-		break;
-	case 0xE7:
-		RST_n(cpu, 0x20);
-		break;
-	case 0xE8:
-		ADD_SP_d(cpu);
-		break;
 	case 0xE9:
-		JP_HL(cpu);
-		break;
-	case 0xEA:
-		LD_cnn_A(cpu);
-		break;
-	case 0xEE:
-		XOR_n(cpu);
-		break;
-	case 0xEF:
-		RST_n(cpu, 0x28);
-		break;
-	case 0xF0:
-		LD_A_cFF00pn(cpu);
-		break;
-	case 0xF1:
-		POP_AF(cpu);
-		break;
-	case 0xF2:
-		LD_A_cFF00pC(cpu);
-		break;
-	case 0xF3:
-		DI(cpu);
-		break;
-	case 0xF5:
-		PUSH_rr(cpu, &cpu->AF);
-		break;
-	case 0xF6:
-		OR_n(cpu);
-		break;
-	case 0xF7:
-		RST_n(cpu, 0x30);
-		break;
-	case 0xF8:
-		LD_HL_SPpd(cpu);
-		break;
-	case 0xF9:
-		LD_SP_HL(cpu);
-		break;
-	case 0xFA:
-		LD_A_cnn(cpu);
-		break;
-	case 0xFB:
-		EI(cpu);
-		break;
-	case 0xFE:
-		CP_n(cpu);
-		break;
-	case 0xFF:
-		RST_n(cpu, 0x38);
-		break;
+		return true;
 	default:
-		LOG_W("lr35902: unknown opcode (%02x)!\n", opcode);
-		clock_consume(1);
-		break;
+		return ((opcode & 0xE7) == 0x20) ||
+			((opcode & 0xE7) == 0xC0) ||
+			((opcode & 0xE7) == 0xC2) ||
+			((opcode & 0xE7) == 0xC4) ||
+			((opcode & 0xC7) == 0xC7);
 	}
 }
 
-void lr35902_opcode_CB(struct lr35902 *cpu)
+bool lr35902_jit_has_side_effects(struct bus *bus, uint16_t address,
+	uint8_t opcode)
 {
-	uint8_t opcode;
-
-	/* Fetch CB opcode */
-	opcode = memory_readb(cpu->bus_id, cpu->PC++);
+	uint8_t cb_opcode;
 
-	/* Execute CB opcode */
+	/* Instructions accessing memory beyond their operands (which can reach
+	I/O registers, request interrupts, remap memory or wake clocks) or
+	changing IME have side effects, as well as unknown opcodes */
 	switch (opcode) {
-	case 0x00:
-		RLC_r(cpu, &cpu->B);
-		break;
-	case 0x01:
-		RLC_r(cpu, &cpu->C);
-		break;
 	case 0x02:
-		RLC_r(cpu, &cpu->D);
-		break;
-	case 0x03:
-		RLC_r(cpu, &cpu->E);
-		break;
-	case 0x04:
-		RLC_r(cpu, &cpu->H);
-		break;
-	case 0x05:
-		RLC_r(cpu, &cpu->L);
-		break;
-	case 0x06:
-		RLC_cHL(cpu);
-		break;
-	case 0x07:
-		RLC_r(cpu, &cpu->A);
-		break;
-	case 0x08:
-		RRC_r(cpu, &cpu->B);
-		break;
-	case 0x09:
-		RRC_r(cpu, &cpu->C);
-		break;
-	case 0x0A:
-		RRC_r(cpu, &cpu->D);
-		break;
-	case 0x0B:
-		RRC_r(cpu, &cpu->E);
-		break;
-	case 0x0C:
-		RRC_r(cpu, &cpu->H);
-		break;
-	case 0x0D:
-		RRC_r(cpu, &cpu->L);
-		break;
-	case 0x0E:
-		RRC_cHL(cpu);
-		break;
-	case 0x0F:
-		RRC_r(cpu, &cpu->A);
-		break;
-	case 0x10:
-		RL_r(cpu, &cpu->B);
-		break;
-	case 0x11:
-		RL_r(cpu, &cpu->C);
-		break;
-	case 0x12:
-		RL_r(cpu, &cpu->D);
-		break;
-	case 0x13:
-		RL_r(cpu, &cpu->E);
-		break;
-	case 0x14:
-		RL_r(cpu, &cpu->H);
-		break;
-	case 0x15:
-		RL_r(cpu, &cpu->L);
-		break;
-	case 0x16:
-		RL_cHL(cpu);
-		break;
-	case 0x17:
-		RL_r(cpu, &cpu->A);
-		break;
-	case 0x18:
-		RR_r(cpu, &cpu->B);
-		break;
-	case 0x19:
-		RR_r(cpu, &cpu->C);
-		break;
-	case 0x1A:
-		RR_r(cpu, &cpu->D);
-		break;
-	case 0x1B:
-		RR_r(cpu, &cpu->E);
-		break;
-	case 0x1C:
-		RR_r(cpu, &cpu->H);
-		break;
-	case 0x1D:
-		RR_r(cpu, &cpu->L);
-		break;
-	case 0x1E:
-		RR_cHL(cpu);
-		break;
-	case 0x1F:
-		RR_r(cpu, &cpu->A);
-		break;
-	case 0x20:
-		SLA_r(cpu, &cpu->B);
-		break;
-	case 0x21:
-		SLA_r(cpu, &cpu->C);
-		break;
-	case 0x22:
-		SLA_r(cpu, &cpu->D);
-		break;
-	case 0x23:
-		SLA_r(cpu, &cpu->E);
-		break;
-	case 0x24:
-		SLA_r(cpu, &cpu->H);
-		break;
-	case 0x25:
-		SLA_r(cpu, &cpu->L);
-		break;
-	case 0x26:
-		SLA_cHL(cpu);
-		break;
-	case 0x27:
-		SLA_r(cpu, &cpu->A);
-		break;
-	case 0x28:
-		SRA_r(cpu, &cpu->B);
-		break;
-	case 0x29:
-		SRA_r(cpu, &cpu->C);
-		break;
+	case 0x08:
+	case 0x0A:
+	case 0x12:
+	case 0x1A:
+	case 0x22:
 	case 0x2A:
-		SRA_r(cpu, &cpu->D);
-		break;
-	case 0x2B:
-		SRA_r(cpu, &cpu->E);
-		break;
-	case 0x2C:
-		SRA_r(cpu, &cpu->H);
-		break;
-	case 0x2D:
-		SRA_r(cpu, &cpu->L);
-		break;
-	case 0x2E:
-		SRA_cHL(cpu);
-		break;
-	case 0x2F:
-		SRA_r(cpu, &cpu->A);
-		break;
-	case 0x30:
-		SWAP_r(cpu, &cpu->B);
-		break;
-	case 0x31:
-		SWAP_r(cpu, &cpu->C);
-		break;
 	case 0x32:
-		SWAP_r(cpu, &cpu->D);
-		break;
-	case 0x33:
-		SWAP_r(cpu, &cpu->E);
-		break;
 	case 0x34:
-		SWAP_r(cpu, &cpu->H);
-		break;
 	case 0x35:
-		SWAP_r(cpu, &cpu->L);
-		break;
 	case 0x36:
-		SWAP_cHL(cpu);
-		break;
-	case 0x37:
-		SWAP_r(cpu, &cpu->A);
-		break;
-	case 0x38:
-		SRL_r(cpu, &cpu->B);
-		break;
-	case 0x39:
-		SRL_r(cpu, &cpu->C);
-		break;
 	case 0x3A:
-		SRL_r(cpu, &cpu->D);
-		break;
-	case 0x3B:
-		SRL_r(cpu, &cpu->E);
-		break;
-	case 0x3C:
-		SRL_r(cpu, &cpu->H);
-		break;
-	case 0x3D:
-		SRL_r(cpu, &cpu->L);
-		break;
-	case 0x3E:
-		SRL_cHL(cpu);
-		break;
-	case 0x3F:
-		SRL_r(cpu, &cpu->A);
-		break;
-	case 0x40:
-		BIT_n_r(cpu, 0, &cpu->B);
-		break;
-	case 0x41:
-		BIT_n_r(cpu, 0, &cpu->C);
-		break;
-	case 0x42:
-		BIT_n_r(cpu, 0, &cpu->D);
-		break;
-	case 0x43:
-		BIT_n_r(cpu, 0, &cpu->E);
-		break;
-	case 0x44:
-		BIT_n_r(cpu, 0, &cpu->H);
-		break;
-	case 0x45:
-		BIT_n_r(cpu, 0, &cpu->L);
-		break;
-	case 0x46:
-		BIT_n_cHL(cpu, 0);
-		break;
-	case 0x47:
-		BIT_n_r(cpu, 0, &cpu->A);
-		break;
-	case 0x48:
-		BIT_n_r(cpu, 1, &cpu->B);
-		break;
-	case 0x49:
-		BIT_n_r(cpu, 1, &cpu->C);
-		break;
-	case 0x4A:
-		BIT_n_r(cpu, 1, &cpu->D);
-		break;
-	case 0x4B:
-		BIT_n_r(cpu, 1, &cpu->E);
-		break;
-	case 0x4C:
-		BIT_n_r(cpu, 1, &cpu->H);
-		break;
-	case 0x4D:
-		BIT_n_r(cpu, 1, &cpu->L);
-		break;
-	case 0x4E:
-		BIT_n_cHL(cpu, 1);
-		break;
-	case 0x4F:
-		BIT_n_r(cpu, 1, &cpu->A);
-		break;
-	case 0x50:
-		BIT_n_r(cpu, 2, &cpu->B);
-		break;
-	case 0x51:
-		BIT_n_r(cpu, 2, &cpu->C);
-		break;
-	case 0x52:
-		BIT_n_r(cpu, 2, &cpu->D);
-		break;
-	case 0x53:
-		BIT_n_r(cpu, 2, &cpu->E);
-		break;
-	case 0x54:
-		BIT_n_r(cpu, 2, &cpu->H);
-		break;
-	case 0x55:
-		BIT_n_r(cpu, 2, &cpu->L);
-		break;
-	case 0x56:
-		BIT_n_cHL(cpu, 2);
-		break;
-	case 0x57:
-		BIT_n_r(cpu, 2, &cpu->A);
-		break;
-	case 0x58:
-		BIT_n_r(cpu, 3, &cpu->B);
-		break;
-	case 0x59:
-		BIT_n_r(cpu, 3, &cpu->C);
-		break;
-	case 0x5A:
-		BIT_n_r(cpu, 3, &cpu->D);
-		break;
-	case 0x5B:
-		BIT_n_r(cpu, 3, &cpu->E);
-		break;
-	case 0x5C:
-		BIT_n_r(cpu, 3, &cpu->H);
-		break;
-	case 0x5D:
-		BIT_n_r(cpu, 3, &cpu->L);
-		break;
-	case 0x5E:
-		BIT_n_cHL(cpu, 3);
-		break;
-	case 0x5F:
-		BIT_n_r(cpu, 3, &cpu->A);
-		break;
-	case 0x60:
-		BIT_n_r(cpu, 4, &cpu->B);
-		break;
-	case 0x61:
-		BIT_n_r(cpu, 4, &cpu->C);
-		break;
-	case 0x62:
-		BIT_n_r(cpu, 4, &cpu->D);
-		break;
-	case 0x63:
-		BIT_n_r(cpu, 4, &cpu->E);
-		break;
-	case 0x64:
-		BIT_n_r(cpu, 4, &cpu->H);
-		break;
-	case 0x65:
-		BIT_n_r(cpu, 4, &cpu->L);
-		break;
-	case 0x66:
-		BIT_n_cHL(cpu, 4);
-		break;
-	case 0x67:
-		BIT_n_r(cpu, 4, &cpu->A);
-		break;
-	case 0x68:
-		BIT_n_r(cpu, 5, &cpu->B);
-		break;
-	case 0x69:
-		BIT_n_r(cpu, 5, &cpu->C);
-		break;
-	case 0x6A:
-		BIT_n_r(cpu, 5, &cpu->D);
-		break;
-	case 0x6B:
-		BIT_n_r(cpu, 5, &cpu->E);
-		break;
-	case 0x6C:
-		BIT_n_r(cpu, 5, &cpu->H);
-		break;
-	case 0x6D:
-		BIT_n_r(cpu, 5, &cpu->L);
-		break;
-	case 0x6E:
-		BIT_n_cHL(cpu, 5);
-		break;
-	case 0x6F:
-		BIT_n_r(cpu, 5, &cpu->A);
-		break;
-	case 0x70:
-		BIT_n_r(cpu, 6, &cpu->B);
-		break;
-	case 0x71:
-		BIT_n_r(cpu, 6, &cpu->C);
-		break;
-	case 0x72:
-		BIT_n_r(cpu, 6, &cpu->D);
-		break;
-	case 0x73:
-		BIT_n_r(cpu, 6, &cpu->E);
-		break;
-	case 0x74:
-		BIT_n_r(cpu, 6, &cpu->H);
-		break;
-	case 0x75:
-		BIT_n_r(cpu, 6, &cpu->L);
-		break;
-	case 0x76:
-		BIT_n_cHL(cpu, 6);
-		break;
-	case 0x77:
-		BIT_n_r(cpu, 6, &cpu->A);
-		break;
-	case 0x78:
-		BIT_n_r(cpu, 7, &cpu->B);
-		break;
-	case 0x79:
-		BIT_n_r(cpu, 7, &cpu->C);
-		break;
-	case 0x7A:
-		BIT_n_r(cpu, 7, &cpu->D);
-		break;
-	case 0x7B:
-		BIT_n_r(cpu, 7, &cpu->E);
-		break;
-	case 0x7C:
-		BIT_n_r(cpu, 7, &cpu->H);
-		break;
-	case 0x7D:
-		BIT_n_r(cpu, 7, &cpu->L);
-		break;
-	case 0x7E:
-		BIT_n_cHL(cpu, 7);
-		break;
-	case 0x7F:
-		BIT_n_r(cpu, 7, &cpu->A);
-		break;
-	case 0x80:
-		RES_n_r(cpu, 0, &cpu->B);
-		break;
-	case 0x81:
-		RES_n_r(cpu, 0, &cpu->C);
-		break;
-	case 0x82:
-		RES_n_r(cpu, 0, &cpu->D);
-		break;
-	case 0x83:
-		RES_n_r(cpu, 0, &cpu->E);
-		break;
-	case 0x84:
-		RES_n_r(cpu, 0, &cpu->H);
-		break;
-	case 0x85:
-		RES_n_r(cpu, 0, &cpu->L);
-		break;
-	case 0x86:
-		RES_n_cHL(cpu, 0);
-		break;
-	case 0x87:
-		RES_n_r(cpu, 0, &cpu->A);
-		break;
-	case 0x88:
-		RES_n_r(cpu, 1, &cpu->B);
-		break;
-	case 0x89:
-		RES_n_r(cpu, 1, &cpu->C);
-		break;
-	case 0x8A:
-		RES_n_r(cpu, 1, &cpu->D);
-		break;
-	case 0x8B:
-		RES_n_r(cpu, 1, &cpu->E);
-		break;
-	case 0x8C:
-		RES_n_r(cpu, 1, &cpu->H);
-		break;
-	case 0x8D:
-		RES_n_r(cpu, 1, &cpu->L);
-		break;
-	case 0x8E:
-		RES_n_cHL(cpu, 1);
-		break;
-	case 0x8F:
-		RES_n_r(cpu, 1, &cpu->A);
-		break;
-	case 0x90:
-		RES_n_r(cpu, 2, &cpu->B);
-		break;
-	case 0x91:
-		RES_n_r(cpu, 2, &cpu->C);
-		break;
-	case 0x92:
-		RES_n_r(cpu, 2, &cpu->D);
-		break;
-	case 0x93:
-		RES_n_r(cpu, 2, &cpu->E);
-		break;
-	case 0x94:
-		RES_n_r(cpu, 2, &cpu->H);
-		break;
-	case 0x95:
-		RES_n_r(cpu, 2, &cpu->L);
-		break;
-	case 0x96:
-		RES_n_cHL(cpu, 2);
-		break;
-	case 0x97:
-		RES_n_r(cpu, 2, &cpu->A);
-		break;
-	case 0x98:
-		RES_n_r(cpu, 3, &cpu->B);
-		break;
-	case 0x99:
-		RES_n_r(cpu, 3, &cpu->C);
-		break;
-	case 0x9A:
-		RES_n_r(cpu, 3, &cpu->D);
-		break;
-	case 0x9B:
-		RES_n_r(cpu, 3, &cpu->E);
-		break;
-	case 0x9C:
-		RES_n_r(cpu, 3, &cpu->H);
-		break;
-	case 0x9D:
-		RES_n_r(cpu, 3, &cpu->L);
-		break;
-	case 0x9E:
-		RES_n_cHL(cpu, 3);
-		break;
-	case 0x9F:
-		RES_n_r(cpu, 3, &cpu->A);
-		break;
-	case 0xA0:
-		RES_n_r(cpu, 4, &cpu->B);
-		break;
-	case 0xA1:
-		RES_n_r(cpu, 4, &cpu->C);
-		break;
-	case 0xA2:
-		RES_n_r(cpu, 4, &cpu->D);
-		break;
-	case 0xA3:
-		RES_n_r(cpu, 4, &cpu->E);
-		break;
-	case 0xA4:
-		RES_n_r(cpu, 4, &cpu->H);
-		break;
-	case 0xA5:
-		RES_n_r(cpu, 4, &cpu->L);
-		break;
-	case 0xA6:
-		RES_n_cHL(cpu, 4);
-		break;
-	case 0xA7:
-		RES_n_r(cpu, 4, &cpu->A);
-		break;
-	case 0xA8:
-		RES_n_r(cpu, 5, &cpu->B);
-		break;
-	case 0xA9:
-		RES_n_r(cpu, 5, &cpu->C);
-		break;
-	case 0xAA:
-		RES_n_r(cpu, 5, &cpu->D);
-		break;
-	case 0xAB:
-		RES_n_r(cpu, 5, &cpu->E);
-		break;
-	case 0xAC:
-		RES_n_r(cpu, 5, &cpu->H);
-		break;
-	case 0xAD:
-		RES_n_r(cpu, 5, &cpu->L);
-		break;
-	case 0xAE:
-		RES_n_cHL(cpu, 5);
-		break;
-	case 0xAF:
-		RES_n_r(cpu, 5, &cpu->A);
-		break;
-	case 0xB0:
-		RES_n_r(cpu, 6, &cpu->B);
-		break;
-	case 0xB1:
-		RES_n_r(cpu, 6, &cpu->C);
-		break;
-	case 0xB2:
-		RES_n_r(cpu, 6, &cpu->D);
-		break;
-	case 0xB3:
-		RES_n_r(cpu, 6, &cpu->E);
-		break;
-	case 0xB4:
-		RES_n_r(cpu, 6, &cpu->H);
-		break;
-	case 0xB5:
-		RES_n_r(cpu, 6, &cpu->L);
-		break;
-	case 0xB6:
-		RES_n_cHL(cpu, 6);
-		break;
-	case 0xB7:
-		RES_n_r(cpu, 6, &cpu->A);
-		break;
-	case 0xB8:
-		RES_n_r(cpu, 7, &cpu->B);
-		break;
-	case 0xB9:
-		RES_n_r(cpu, 7, &cpu->C);
-		break;
-	case 0xBA:
-		RES_n_r(cpu, 7, &cpu->D);
-		break;
-	case 0xBB:
-		RES_n_r(cpu, 7, &cpu->E);
-		break;
-	case 0xBC:
-		RES_n_r(cpu, 7, &cpu->H);
-		break;
-	case 0xBD:
-		RES_n_r(cpu, 7, &cpu->L);
-		break;
-	case 0xBE:
-		RES_n_cHL(cpu, 7);
-		break;
-	case 0xBF:
-		RES_n_r(cpu, 7, &cpu->A);
-		break;
-	case 0xC0:
-		SET_n_r(cpu, 0, &cpu->B);
-		break;
-	case 0xC1:
-		SET_n_r(cpu, 0, &cpu->C);
-		break;
-	case 0xC2:
-		SET_n_r(cpu, 0, &cpu->D);
-		break;
-	case 0xC3:
-		SET_n_r(cpu, 0, &cpu->E);
-		break;
-	case 0xC4:
-		SET_n_r(cpu, 0, &cpu->H);
-		break;
-	case 0xC5:
-		SET_n_r(cpu, 0, &cpu->L);
-		break;
-	case 0xC6:
-		SET_n_cHL(cpu, 0);
-		break;
-	case 0xC7:
-		SET_n_r(cpu, 0, &cpu->A);
-		break;
-	case 0xC8:
-		SET_n_r(cpu, 1, &cpu->B);
-		break;
-	case 0xC9:
-		SET_n_r(cpu, 1, &cpu->C);
-		break;
-	case 0xCA:
-		SET_n_r(cpu, 1, &cpu->D);
-		break;
-	case 0xCB:
-		SET_n_r(cpu, 1, &cpu->E);
-		break;
-	case 0xCC:
-		SET_n_r(cpu, 1, &cpu->H);
-		break;
-	case 0xCD:
-		SET_n_r(cpu, 1, &cpu->L);
-		break;
-	case 0xCE:
-		SET_n_cHL(cpu, 1);
-		break;
-	case 0xCF:
-		SET_n_r(cpu, 1, &cpu->A);
-		break;
-	case 0xD0:
-		SET_n_r(cpu, 2, &cpu->B);
-		break;
-	case 0xD1:
-		SET_n_r(cpu, 2, &cpu->C);
-		break;
-	case 0xD2:
-		SET_n_r(cpu, 2, &cpu->D);
-		break;
 	case 0xD3:
-		SET_n_r(cpu, 2, &cpu->E);
-		break;
-	case 0xD4:
-		SET_n_r(cpu, 2, &cpu->H);
-		break;
-	case 0xD5:
-		SET_n_r(cpu, 2, &cpu->L);
-		break;
-	case 0xD6:
-		SET_n_cHL(cpu, 2);
-		break;
-	case 0xD7:
-		SET_n_r(cpu, 2, &cpu->A);
-		break;
-	case 0xD8:
-		SET_n_r(cpu, 3, &cpu->B);
-		break;
-	case 0xD9:
-		SET_n_r(cpu, 3, &cpu->C);
-		break;
-	case 0xDA:
-		SET_n_r(cpu, 3, &cpu->D);
-		break;
 	case 0xDB:
-		SET_n_r(cpu, 3, &cpu->E);
-		break;
-	case 0xDC:
-		SET_n_r(cpu, 3, &cpu->H);
-		break;
 	case 0xDD:
-		SET_n_r(cpu, 3, &cpu->L);
-		break;
-	case 0xDE:
-		SET_n_cHL(cpu, 3);
-		break;
-	case 0xDF:
-		SET_n_r(cpu, 3, &cpu->A);
-		break;
 	case 0xE0:
-		SET_n_r(cpu, 4, &cpu->B);
-		break;
-	case 0xE1:
-		SET_n_r(cpu, 4, &cpu->C);
-		break;
 	case 0xE2:
-		SET_n_r(cpu, 4, &cpu->D);
-		break;
 	case 0xE3:
-		SET_n_r(cpu, 4, &cpu->E);
-		break;
 	case 0xE4:
-		SET_n_r(cpu, 4, &cpu->H);
-		break;
-	case 0xE5:
-		SET_n_r(cpu, 4, &cpu->L);
-		break;
-	case 0xE6:
-		SET_n_cHL(cpu, 4);
-		break;
-	case 0xE7:
-		SET_n_r(cpu, 4, &cpu->A);
-		break;
-	case 0xE8:
-		SET_n_r(cpu, 5, &cpu->B);
-		break;
-	case 0xE9:
-		SET_n_r(cpu, 5, &cpu->C);
-		break;
 	case 0xEA:
-		SET_n_r(cpu, 5, &cpu->D);
-		break;
 	case 0xEB:
-		SET_n_r(cpu, 5, &cpu->E);
-		break;
 	case 0xEC:
-		SET_n_r(cpu, 5, &cpu->H);
-		break;
 	case 0xED:
-		SET_n_r(cpu, 5, &cpu->L);
-		break;
-	case 0xEE:
-		SET_n_cHL(cpu, 5);
-		break;
-	case 0xEF:
-		SET_n_r(cpu, 5, &cpu->A);
-		break;
 	case 0xF0:
-		SET_n_r(cpu, 6, &cpu->B);
-		break;
-	case 0xF1:
-		SET_n_r(cpu, 6, &cpu->C);
-		break;
 	case 0xF2:
-		SET_n_r(cpu, 6, &cpu->D);
-		break;
 	case 0xF3:
-		SET_n_r(cpu, 6, &cpu->E);
-		break;
 	case 0xF4:
-		SET_n_r(cpu, 6, &cpu->H);
-		break;
-	case 0xF5:
-		SET_n_r(cpu, 6, &cpu->L);
-		break;
-	case 0xF6:
-		SET_n_cHL(cpu, 6);
-		break;
-	case 0xF7:
-		SET_n_r(cpu, 6, &cpu->A);
-		break;
-	case 0xF8:
-		SET_n_r(cpu, 7, &cpu->B);
-		break;
-	case 0xF9:
-		SET_n_r(cpu, 7, &cpu->C);
-		break;
 	case 0xFA:
-		SET_n_r(cpu, 7, &cpu->D);
-		break;
 	case 0xFB:
-		SET_n_r(cpu, 7, &cpu->E);
-		break;
 	case 0xFC:
-		SET_n_r(cpu, 7, &cpu->H);
-		break;
 	case 0xFD:
-		SET_n_r(cpu, 7, &cpu->L);
-		break;
-	case 0xFE:
-		SET_n_cHL(cpu, 7);
-		break;
-	case 0xFF:
-		SET_n_r(cpu, 7, &cpu->A);
-		break;
+		return true;
+	case 0xCB:
+		/* CB-prefixed instructions access (HL) as register 6 (assume
+		they do if second opcode cannot be peeked at) */
+		if (!lr35902_jit_decode(bus, address + 1, &cb_opcode))
+			return true;
+		return ((cb_opcode & 0x07) == 0x06);
 	default:
-		LOG_W("lr35902: unknown opcode (%02x)!\n", opcode);
-		clock_consume(1);
-		break;
+		/* Loads and ALU operations using (HL), PUSH and POP */
+		if ((opcode >= 0x40) && (opcode < 0xC0))
+			return ((opcode & 0x07) == 0x06) ||
+				((opcode & 0xF8) == 0x70);
+		return ((opcode & 0xCB) == 0xC1);
+	}
+}
+
+jit_block_t lr35902_jit_translate(struct lr35902 *cpu, bool retry)
+{
+	struct bus *bus = &busses[cpu->bus_id];
+	struct jit *jit = cpu->jit;
+	uint16_t addresses[MAX_BLOCK_INSTRUCTIONS];
+	uint8_t opcodes[MAX_BLOCK_INSTRUCTIONS];
+	bool side_effects[MAX_BLOCK_INSTRUCTIONS];
+	uint16_t address = cpu->PC;
+	int num_instructions;
+	int num_cycles;
+	bool may_leave;
+	jit_block_t block;
+	int i;
+	int j;
+
+	/* Decode block up to first instruction that cannot be translated or
+	after instructions changing PC or halting CPU */
+	for (i = 0; i < MAX_BLOCK_INSTRUCTIONS; i++) {
+		if (!lr35902_jit_decode(bus, address, &opcodes[i]))
+			break;
+		addresses[i] = address;
+		side_effects[i] = lr35902_jit_has_side_effects(bus, address,
+			opcodes[i]);
+		address += lr35902_lengths[opcodes[i]];
+		if (lr35902_jit_ends_block(opcodes[i])) {
+			i++;
+			break;
+		}
+	}
+	num_instructions = i;
+
+	/* Leave already if first instruction cannot be translated or if code
+	buffer cannot be written */
+	if ((num_instructions == 0) || !jit_begin(jit))
+		return NULL;
+
+	for (i = 0; i < num_instructions; i++) {
+		/* Leave block before second instruction and after instructions
+		with side effects if another clock might be due before the next
+		check, bounded by the longest cycle counts of instructions run
+		until then (caller checks first instruction) */
+		if ((i == 1) || ((i > 1) && side_effects[i - 1])) {
+			num_cycles = 0;
+			for (j = i; (j < num_instructions - 1) &&
+				!side_effects[j]; j++)
+				num_cycles += lr35902_cycles[opcodes[j]];
+			num_cycles *= cpu->clock.div +
+				(cpu->clock.frac ? 1 : 0);
+			jit_exit_unless_below(jit,
+				offsetof(struct lr35902, clock.next_cycle),
+				num_cycles,
+				offsetof(struct lr35902, clock.deadline));
+		}
+
+		/* Side effects can also request an enabled interrupt while
+		interrupts are enabled or change the page table, leaving
+		remaining code unmapped */
+		if ((i > 0) && side_effects[i - 1]) {
+			jit_exit_if_masked(jit,
+				offsetof(struct lr35902, IME),
+				offsetof(struct lr35902, IF),
+				offsetof(struct lr35902, IE));
+			jit_exit_if_changed(jit,
+				offsetof(struct lr35902, jit_bus_generation),
+				offsetof(struct lr35902, jit_generation));
+		}
+
+		/* Latch opcode on data bus and point PC to operands (as
+		fetching would), which only matters to instructions reading
+		operands or memory and when block may be left right after */
+		may_leave = (i == 0) || side_effects[i] ||
+			(i == num_instructions - 1);
+		if ((lr35902_lengths[opcodes[i]] == 1) && may_leave)
+			jit_store8_ptr(jit,
+				offsetof(struct lr35902, jit_open_bus),
+				opcodes[i]);
+		if ((lr35902_lengths[opcodes[i]] > 1) || may_leave)
+			jit_store16(jit, offsetof(struct lr35902, PC),
+				addresses[i] + 1);
+
+		/* Run handler */
+		jit_call(jit, lr35902_handlers[opcodes[i]]);
+	}
+
+	/* Flush all blocks and translate again (once) if code buffer is
+	full */
+	block = jit_end(jit);
+	if (!block && retry && !jit_failed(jit)) {
+		lr35902_jit_flush(cpu);
+		block = lr35902_jit_translate(cpu, false);
+	}
+
+	return block;
+}
+
+jit_block_t lr35902_jit_get_block(struct lr35902 *cpu)
+{
+	struct bus *bus = &busses[cpu->bus_id];
+	struct lr35902_jit_page *jit_page;
+	jit_block_t block;
+
+	/* Use translated block unless page table changed since translating */
+	jit_page = cpu->jit_pages[cpu->PC >> BUS_PAGE_BITS];
+	if (jit_page && (jit_page->generation == bus->generation)) {
+		block = jit_page->blocks[cpu->PC & BUS_PAGE_MASK];
+		if (block)
+			return block;
+	}
+
+	/* Translate block and stop translating if code buffer protection
+	could not be changed */
+	block = lr35902_jit_translate(cpu, true);
+	if (jit_failed(cpu->jit)) {
+		LOG_E("lr35902: JIT code buffer unusable, disabling JIT!\n");
+		cpu->jit_mode = JIT_OFF;
+		return NULL;
+	}
+	if (!block)
+		return NULL;
+
+	/* Allocate block page if needed and flush it if page table changed */
+	jit_page = cpu->jit_pages[cpu->PC >> BUS_PAGE_BITS];
+	if (!jit_page) {
+		jit_page = calloc(1, sizeof(struct lr35902_jit_page));
+		cpu->jit_pages[cpu->PC >> BUS_PAGE_BITS] = jit_page;
+	} else if (jit_page->generation != bus->generation) {
+		memset(jit_page, 0, sizeof(struct lr35902_jit_page));
 	}
+	jit_page->generation = bus->generation;
+
+	/* Save block */
+	jit_page->blocks[cpu->PC & BUS_PAGE_MASK] = block;
+	return block;
+}
+
+void lr35902_jit_flush(struct lr35902 *cpu)
+{
+	int i;
+
+	/* Discard code buffer and drop all block references */
+	jit_flush(cpu->jit);
+	for (i = 0; i < NUM_JIT_PAGES; i++)
+		if (cpu->jit_pages[i])
+			memset(cpu->jit_pages[i]->blocks, 0,
+				sizeof(cpu->jit_pages[i]->blocks));
 }
 
+void lr35902_jit_tick(clock_data_t *data)
+{
+	struct lr35902 *cpu = data;
+	struct bus *bus = &busses[cpu->bus_id];
+	jit_block_t block;
+
+	/* Point blocks to bus state they check and update */
+	cpu->jit_bus_generation = &bus->generation;
+	cpu->jit_open_bus = &bus->open_bus;
+
+	/* Execute blocks until another clock is due (instructions which
+	cannot be translated are interpreted) */
+	do {
+		/* Check for interrupt requests */
+		if (lr35902_handle_interrupts(cpu))
+			continue;
+
+		/* Check if CPU is halted */
+		if (cpu->halted) {
+			clock_consume(1);
+			continue;
+		}
+
+		block = NULL;
+		if (cpu->jit_mode != JIT_OFF)
+			block = lr35902_jit_get_block(cpu);
+
+		if (block) {
+			cpu->jit_generation = bus->generation;
+			block(cpu);
+		} else {
+			lr35902_handlers[memory_fetchb(cpu->bus_id,
+				cpu->PC++)](cpu);
+		}
+	} while (clock_run_ahead());
+}
+
+#endif
+
 bool lr35902_init(struct cpu_instance *instance)
 {
 	struct lr35902 *cpu;
@@ -2801,10 +1623,26 @@ bool lr35902_init(struct cpu_instance *instance)
 
 	/* Initialize processor data */
 	cpu->bus_id = instance->bus_id;
+	cpu->AF = 0;
+	cpu->BC = 0;
+	cpu->DE = 0;
+	cpu->HL = 0;
 	cpu->PC = 0;
+	cpu->SP = 0;
 	cpu->IME = 0;
 	cpu->IF = 0;
 	cpu->IE = 0;
+	cpu->halted = false;
+
+	/* Map register indexes used by opcode fields (HL is indirect) */
+	cpu->regs[0] = &cpu->B;
+	cpu->regs[1] = &cpu->C;
+	cpu->regs[2] = &cpu->D;
+	cpu->regs[3] = &cpu->E;
+	cpu->regs[4] = &cpu->H;
+	cpu->regs[5] = &cpu->L;
+	cpu->regs[6] = NULL;
+	cpu->regs[7] = &cpu->A;
 
 	/* Add CPU clock */
 	res = resource_get("clk",
@@ -2814,6 +1652,20 @@ bool lr35902_init(struct cpu_instance *instance)
 	cpu->clock.rate = res->data.clk;
 	cpu->clock.data = cpu;
 	cpu->clock.tick = lr35902_tick;
+
+#ifdef CONFIG_CPU_LR35902_JIT
+	/* Translate blocks if requested (JIT is set up per instance, machine
+	instance mode overriding option) */
+	memset(cpu->jit_pages, 0, sizeof(cpu->jit_pages));
+	cpu->jit = NULL;
+	cpu->jit_mode = jit_get_mode(instance->jit_mode ?
+		instance->jit_mode : jit_mode_name);
+	if (cpu->jit_mode != JIT_OFF)
+		cpu->jit = jit_create(JIT_BUFFER_SIZE);
+	if (cpu->jit)
+		cpu->clock.tick = lr35902_jit_tick;
+#endif
+
 	clock_add(&cpu->clock);
 
 	/* Add IF memory region */
@@ -2844,6 +1696,16 @@ void lr35902_interrupt(struct cpu_instance *instance, int irq)
 void lr35902_deinit(struct cpu_instance *instance)
 {
 	struct lr35902 *cpu = instance->priv_data;
+#ifdef CONFIG_CPU_LR35902_JIT
+	int i;
+
+	/* Free translated blocks */
+	for (i = 0; i < NUM_JIT_PAGES; i++)
+		free(cpu->jit_pages[i]);
+	if (cpu->jit)
+		jit_destroy(cpu->jit);
+#endif
+
 	free(cpu);
 }
 
@@ -3,7 +3,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <clock.h>
+#include <cmdline.h>
+#include <config.h>
 #include <cpu.h>
+#ifdef CONFIG_CPU_RP2A03_JIT
+#include <jit.h>
+#endif
 #include <log.h>
 #include <memory.h>
 #include <util.h>
@@ -14,6 +19,227 @@
 #define STACK_START		0x100
 #define ZP_SIZE			0x100
 
+/* Decoded instructions are cached per 256-byte page of address space */
+#define NUM_CACHE_PAGES		(0x10000 >> BUS_PAGE_BITS)
+
+/* Translated blocks share a code buffer and hold a limited instruction count */
+#define JIT_BUFFER_SIZE		KB(1024)
+#define MAX_BLOCK_INSTRUCTIONS	32
+
+/* Instruction reading its operand through an addressing mode */
+#define READ_INSTRUCTION(op, mode, num_cycles) \
+	static inline void op##_##mode(struct rp2a03 *rp2a03) \
+	{ \
+		uint16_t address = ADDR_##mode(rp2a03); \
+		op(rp2a03, memory_readb(rp2a03->bus_id, address)); \
+		clock_consume(num_cycles); \
+	}
+
+/* Instruction reading, modifying and writing back its operand */
+#define RMW_INSTRUCTION(op, mode, num_cycles) \
+	static inline void op##_##mode(struct rp2a03 *rp2a03) \
+	{ \
+		uint16_t address = ADDR_##mode(rp2a03); \
+		uint8_t b = memory_readb(rp2a03->bus_id, address); \
+		memory_writeb(rp2a03->bus_id, op(rp2a03, b), address); \
+		clock_consume(num_cycles); \
+	}
+
+/* Instruction reading its immediate operand */
+#define IMM_INSTRUCTION(op) \
+	static inline void op##_I(struct rp2a03 *rp2a03) \
+	{ \
+		op(rp2a03, rp2a03->operand); \
+		clock_consume(2); \
+	}
+
+/* Instruction modifying the accumulator in place */
+#define ACC_INSTRUCTION(op) \
+	static inline void op##_ACC(struct rp2a03 *rp2a03) \
+	{ \
+		rp2a03->A = op(rp2a03, rp2a03->A); \
+		clock_consume(2); \
+	}
+
+/* Instruction storing a register through an addressing mode */
+#define STORE_INSTRUCTION(op, reg, mode, num_cycles) \
+	static inline void op##_##mode(struct rp2a03 *rp2a03) \
+	{ \
+		uint16_t address = ADDR_##mode(rp2a03); \
+		memory_writeb(rp2a03->bus_id, rp2a03->reg, address); \
+		clock_consume(num_cycles); \
+	}
+
+/* Relative branch taken if condition is met */
+#define BRANCH_INSTRUCTION(op, condition) \
+	static inline void op(struct rp2a03 *rp2a03) \
+	{ \
+		if (condition) { \
+			rp2a03->PC += (int8_t)rp2a03->operand; \
+			clock_consume(1); \
+		} \
+		clock_consume(2); \
+	}
+
+/* Instruction clearing or setting a flag */
+#define FLAG_INSTRUCTION(op, flag, value) \
+	static inline void op(struct rp2a03 *rp2a03) \
+	{ \
+		rp2a03->flag = value; \
+		clock_consume(2); \
+	}
+
+/* Instruction transferring a register to another one */
+#define TRANSFER_INSTRUCTION(op, src, dst) \
+	static inline void op(struct rp2a03 *rp2a03) \
+	{ \
+		rp2a03->dst = rp2a03->src; \
+		rp2a03->Z = (rp2a03->dst == 0); \
+		rp2a03->N = ((rp2a03->dst & 0x80) != 0); \
+		clock_consume(2); \
+	}
+
+/* Instruction incrementing or decrementing an index register */
+#define STEP_INSTRUCTION(op, reg, delta) \
+	static inline void op(struct rp2a03 *rp2a03) \
+	{ \
+		rp2a03->reg += delta; \
+		rp2a03->Z = (rp2a03->reg == 0); \
+		rp2a03->N = ((rp2a03->reg & 0x80) != 0); \
+		clock_consume(2); \
+	}
+
+/* Opcode map with instruction lengths (unknown opcodes are handled by UNK) */
+#define RP2A03_OPCODES(OP) \
+	OP(0x00, BRK, 1) OP(0x01, ORA_IX, 2) \
+	OP(0x02, UNK, 1) OP(0x03, UNK, 1) \
+	OP(0x04, NOP_D, 2) OP(0x05, ORA_ZP, 2) \
+	OP(0x06, ASL_ZP, 2) OP(0x07, UNK, 1) \
+	OP(0x08, PHP, 1) OP(0x09, ORA_I, 2) \
+	OP(0x0A, ASL_ACC, 1) OP(0x0B, UNK, 1) \
+	OP(0x0C, NOP_A, 3) OP(0x0D, ORA_A, 3) \
+	OP(0x0E, ASL_A, 3) OP(0x0F, UNK, 1) \
+	OP(0x10, BPL, 2) OP(0x11, ORA_IY, 2) \
+	OP(0x12, UNK, 1) OP(0x13, UNK, 1) \
+	OP(0x14, UNK, 1) OP(0x15, ORA_ZPX, 2) \
+	OP(0x16, ASL_ZPX, 2) OP(0x17, UNK, 1) \
+	OP(0x18, CLC, 1) OP(0x19, ORA_AY, 3) \
+	OP(0x1A, UNK, 1) OP(0x1B, UNK, 1) \
+	OP(0x1C, UNK, 1) OP(0x1D, ORA_AX, 3) \
+	OP(0x1E, ASL_AX, 3) OP(0x1F, UNK, 1) \
+	OP(0x20, JSR, 3) OP(0x21, AND_IX, 2) \
+	OP(0x22, UNK, 1) OP(0x23, UNK, 1) \
+	OP(0x24, BIT_ZP, 2) OP(0x25, AND_ZP, 2) \
+	OP(0x26, ROL_ZP, 2) OP(0x27, UNK, 1) \
+	OP(0x28, PLP, 1) OP(0x29, AND_I, 2) \
+	OP(0x2A, ROL_ACC, 1) OP(0x2B, UNK, 1) \
+	OP(0x2C, BIT_A, 3) OP(0x2D, AND_A, 3) \
+	OP(0x2E, ROL_A, 3) OP(0x2F, UNK, 1) \
+	OP(0x30, BMI, 2) OP(0x31, AND_IY, 2) \
+	OP(0x32, UNK, 1) OP(0x33, UNK, 1) \
+	OP(0x34, UNK, 1) OP(0x35, AND_ZPX, 2) \
+	OP(0x36, ROL_ZPX, 2) OP(0x37, UNK, 1) \
+	OP(0x38, SEC, 1) OP(0x39, AND_AY, 3) \
+	OP(0x3A, UNK, 1) OP(0x3B, UNK, 1) \
+	OP(0x3C, UNK, 1) OP(0x3D, AND_AX, 3) \
+	OP(0x3E, ROL_AX, 3) OP(0x3F, UNK, 1) \
+	OP(0x40, RTI, 1) OP(0x41, EOR_IX, 2) \
+	OP(0x42, UNK, 1) OP(0x43, UNK, 1) \
+	OP(0x44, NOP_D, 2) OP(0x45, EOR_ZP, 2) \
+	OP(0x46, LSR_ZP, 2) OP(0x47, UNK, 1) \
+	OP(0x48, PHA, 1) OP(0x49, EOR_I, 2) \
+	OP(0x4A, LSR_ACC, 1) OP(0x4B, UNK, 1) \
+	OP(0x4C, JMP_A, 3) OP(0x4D, EOR_A, 3) \
+	OP(0x4E, LSR_A, 3) OP(0x4F, UNK, 1) \
+	OP(0x50, BVC, 2) OP(0x51, EOR_IY, 2) \
+	OP(0x52, UNK, 1) OP(0x53, UNK, 1) \
+	OP(0x54, UNK, 1) OP(0x55, EOR_ZPX, 2) \
+	OP(0x56, LSR_ZPX, 2) OP(0x57, UNK, 1) \
+	OP(0x58, UNK, 1) OP(0x59, EOR_AY, 3) \
+	OP(0x5A, UNK, 1) OP(0x5B, UNK, 1) \
+	OP(0x5C, UNK, 1) OP(0x5D, EOR_AX, 3) \
+	OP(0x5E, LSR_AX, 3) OP(0x5F, UNK, 1) \
+	OP(0x60, RTS, 1) OP(0x61, ADC_IX, 2) \
+	OP(0x62, UNK, 1) OP(0x63, UNK, 1) \
+	OP(0x64, NOP_D, 2) OP(0x65, ADC_ZP, 2) \
+	OP(0x66, ROR_ZP, 2) OP(0x67, UNK, 1) \
+	OP(0x68, PLA, 1) OP(0x69, ADC_I, 2) \
+	OP(0x6A, ROR_ACC, 1) OP(0x6B, UNK, 1) \
+	OP(0x6C, JMP_I, 3) OP(0x6D, ADC_A, 3) \
+	OP(0x6E, ROR_A, 3) OP(0x6F, UNK, 1) \
+	OP(0x70, BVS, 2) OP(0x71, ADC_IY, 2) \
+	OP(0x72, UNK, 1) OP(0x73, UNK, 1) \
+	OP(0x74, UNK, 1) OP(0x75, ADC_ZPX, 2) \
+	OP(0x76, ROR_ZPX, 2) OP(0x77, UNK, 1) \
+	OP(0x78, SEI, 1) OP(0x79, ADC_AY, 3) \
+	OP(0x7A, UNK, 1) OP(0x7B, UNK, 1) \
+	OP(0x7C, UNK, 1) OP(0x7D, ADC_AX, 3) \
+	OP(0x7E, ROR_AX, 3) OP(0x7F, UNK, 1) \
+	OP(0x80, UNK, 1) OP(0x81, STA_IX, 2) \
+	OP(0x82, UNK, 1) OP(0x83, UNK, 1) \
+	OP(0x84, STY_ZP, 2) OP(0x85, STA_ZP, 2) \
+	OP(0x86, STX_ZP, 2) OP(0x87, UNK, 1) \
+	OP(0x88, DEY, 1) OP(0x89, UNK, 1) \
+	OP(0x8A, TXA, 1) OP(0x8B, UNK, 1) \
+	OP(0x8C, STY_A, 3) OP(0x8D, STA_A, 3) \
+	OP(0x8E, STX_A, 3) OP(0x8F, UNK, 1) \
+	OP(0x90, BCC, 2) OP(0x91, STA_IY, 2) \
+	OP(0x92, UNK, 1) OP(0x93, UNK, 1) \
+	OP(0x94, STY_ZPX, 2) OP(0x95, STA_ZPX, 2) \
+	OP(0x96, STX_ZPY, 2) OP(0x97, UNK, 1) \
+	OP(0x98, TYA, 1) OP(0x99, STA_AY, 3) \
+	OP(0x9A, TXS, 1) OP(0x9B, UNK, 1) \
+	OP(0x9C, UNK, 1) OP(0x9D, STA_AX, 3) \
+	OP(0x9E, UNK, 1) OP(0x9F, UNK, 1) \
+	OP(0xA0, LDY_I, 2) OP(0xA1, LDA_IX, 2) \
+	OP(0xA2, LDX_I, 2) OP(0xA3, UNK, 1) \
+	OP(0xA4, LDY_ZP, 2) OP(0xA5, LDA_ZP, 2) \
+	OP(0xA6, LDX_ZP, 2) OP(0xA7, UNK, 1) \
+	OP(0xA8, TAY, 1) OP(0xA9, LDA_I, 2) \
+	OP(0xAA, TAX, 1) OP(0xAB, UNK, 1) \
+	OP(0xAC, LDY_A, 3) OP(0xAD, LDA_A, 3) \
+	OP(0xAE, LDX_A, 3) OP(0xAF, UNK, 1) \
+	OP(0xB0, BCS, 2) OP(0xB1, LDA_IY, 2) \
+	OP(0xB2, UNK, 1) OP(0xB3, UNK, 1) \
+	OP(0xB4, LDY_ZPX, 2) OP(0xB5, LDA_ZPX, 2) \
+	OP(0xB6, LDX_ZPY, 2) OP(0xB7, UNK, 1) \
+	OP(0xB8, CLV, 1) OP(0xB9, LDA_AY, 3) \
+	OP(0xBA, TSX, 1) OP(0xBB, UNK, 1) \
+	OP(0xBC, LDY_AX, 3) OP(0xBD, LDA_AX, 3) \
+	OP(0xBE, LDX_AY, 3) OP(0xBF, UNK, 1) \
+	OP(0xC0, CPY_I, 2) OP(0xC1, CMP_IX, 2) \
+	OP(0xC2, UNK, 1) OP(0xC3, UNK, 1) \
+	OP(0xC4, CPY_ZP, 2) OP(0xC5, CMP_ZP, 2) \
+	OP(0xC6, DEC_ZP, 2) OP(0xC7, UNK, 1) \
+	OP(0xC8, INY, 1) OP(0xC9, CMP_I, 2) \
+	OP(0xCA, DEX, 1) OP(0xCB, UNK, 1) \
+	OP(0xCC, CPY_A, 3) OP(0xCD, CMP_A, 3) \
+	OP(0xCE, DEC_A, 3) OP(0xCF, UNK, 1) \
+	OP(0xD0, BNE, 2) OP(0xD1, CMP_IY, 2) \
+	OP(0xD2, UNK, 1) OP(0xD3, UNK, 1) \
+	OP(0xD4, UNK, 1) OP(0xD5, CMP_ZPX, 2) \
+	OP(0xD6, DEC_ZPX, 2) OP(0xD7, UNK, 1) \
+	OP(0xD8, CLD, 1) OP(0xD9, CMP_AY, 3) \
+	OP(0xDA, UNK, 1) OP(0xDB, UNK, 1) \
+	OP(0xDC, UNK, 1) OP(0xDD, CMP_AX, 3) \
+	OP(0xDE, DEC_AX, 3) OP(0xDF, UNK, 1) \
+	OP(0xE0, CPX_I, 2) OP(0xE1, SBC_IX, 2) \
+	OP(0xE2, UNK, 1) OP(0xE3, UNK, 1) \
+	OP(0xE4, CPX_ZP, 2) OP(0xE5, SBC_ZP, 2) \
+	OP(0xE6, INC_ZP, 2) OP(0xE7, UNK, 1) \
+	OP(0xE8, INX, 1) OP(0xE9, SBC_I, 2) \
+	OP(0xEA, NOP, 1) OP(0xEB, UNK, 1) \
+	OP(0xEC, CPX_A, 3) OP(0xED, SBC_A, 3) \
+	OP(0xEE, INC_A, 3) OP(0xEF, UNK, 1) \
+	OP(0xF0, BEQ, 2) OP(0xF1, SBC_IY, 2) \
+	OP(0xF2, UNK, 1) OP(0xF3, UNK, 1) \
+	OP(0xF4, UNK, 1) OP(0xF5, SBC_ZPX, 2) \
+	OP(0xF6, INC_ZPX, 2) OP(0xF7, UNK, 1) \
+	OP(0xF8, SED, 1) OP(0xF9, SBC_AY, 3) \
+	OP(0xFA, UNK, 1) OP(0xFB, UNK, 1) \
+	OP(0xFC, UNK, 1) OP(0xFD, SBC_AX, 3) \
+	OP(0xFE, INC_AX, 3) OP(0xFF, UNK, 1)
+
 struct rp2a03 {
 	uint8_t A;
 	uint8_t X;
@@ -34,289 +260,166 @@ struct rp2a03 {
 		};
 	};
 	bool interrupted;
+	uint16_t operand;
 	int bus_id;
 	int nmi;
+	struct rp2a03_cache_page *cache[NUM_CACHE_PAGES];
+#ifdef CONFIG_CPU_RP2A03_JIT
+	struct jit *jit;
+	enum jit_mode jit_mode;
+	unsigned int jit_generation;
+	unsigned int *jit_bus_generation;
+	uint8_t *jit_open_bus;
+#endif
 	struct clock clock;
 };
 
+struct rp2a03_decoded {
+	uint16_t operand;
+	uint8_t opcode;
+	uint8_t length;
+	uint8_t open_bus;
+};
+
+struct rp2a03_cache_page {
+	unsigned int generation;
+	struct rp2a03_decoded entries[BUS_PAGE_SIZE];
+#ifdef CONFIG_CPU_RP2A03_JIT
+	jit_block_t blocks[BUS_PAGE_SIZE];
+#endif
+};
+
+typedef void (*rp2a03_handler_t)(struct rp2a03 *rp2a03);
+
 static bool rp2a03_init(struct cpu_instance *instance);
 static void rp2a03_interrupt(struct cpu_instance *instance, int irq);
 static void rp2a03_deinit(struct cpu_instance *instance);
 static void rp2a03_tick(clock_data_t *data);
-static inline void ADC_A(struct rp2a03 *rp2a03);
-static inline void ADC_AX(struct rp2a03 *rp2a03);
-static inline void ADC_AY(struct rp2a03 *rp2a03);
-static inline void ADC_I(struct rp2a03 *rp2a03);
-static inline void ADC_IX(struct rp2a03 *rp2a03);
-static inline void ADC_IY(struct rp2a03 *rp2a03);
-static inline void ADC_ZP(struct rp2a03 *rp2a03);
-static inline void ADC_ZPX(struct rp2a03 *rp2a03);
+static void rp2a03_nmi(struct rp2a03 *rp2a03);
+static inline uint8_t rp2a03_fetch(struct rp2a03 *rp2a03);
+static uint8_t rp2a03_decode(struct rp2a03 *rp2a03);
+static bool rp2a03_cacheable(struct bus *bus, uint16_t address);
+static struct rp2a03_cache_page *rp2a03_cache_get(struct rp2a03 *rp2a03,
+	uint16_t address);
+#ifndef CONFIG_CPU_RP2A03_THREADED
+static void rp2a03_step(struct rp2a03 *rp2a03);
+#endif
+#ifdef CONFIG_CPU_RP2A03_JIT
+static uint8_t rp2a03_jit_decode(struct bus *bus, uint16_t address,
+	uint8_t *opcode, uint16_t *operand);
+static bool rp2a03_jit_ends_block(uint8_t opcode);
+static jit_block_t rp2a03_jit_translate(struct rp2a03 *rp2a03, bool retry);
+static jit_block_t rp2a03_jit_get_block(struct rp2a03 *rp2a03);
+static void rp2a03_jit_flush(struct rp2a03 *rp2a03);
+static void rp2a03_jit_tick(clock_data_t *data);
+#endif
+static inline uint16_t ADDR_A(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_AX(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_AY(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_IX(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_IY(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_ZP(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_ZPX(struct rp2a03 *rp2a03);
+static inline uint16_t ADDR_ZPY(struct rp2a03 *rp2a03);
+static inline void ADC(struct rp2a03 *rp2a03, uint8_t b);
 static inline void AND(struct rp2a03 *rp2a03, uint8_t b);
-static inline void AND_A(struct rp2a03 *rp2a03);
-static inline void AND_AX(struct rp2a03 *rp2a03);
-static inline void AND_AY(struct rp2a03 *rp2a03);
-static inline void AND_I(struct rp2a03 *rp2a03);
-static inline void AND_IX(struct rp2a03 *rp2a03);
-static inline void AND_IY(struct rp2a03 *rp2a03);
-static inline void AND_ZP(struct rp2a03 *rp2a03);
-static inline void AND_ZPX(struct rp2a03 *rp2a03);
-static inline void ASL_ACC(struct rp2a03 *rp2a03);
-static inline void ASL_A(struct rp2a03 *rp2a03);
-static inline void ASL_AX(struct rp2a03 *rp2a03);
-static inline void ASL_ZP(struct rp2a03 *rp2a03);
-static inline void ASL_ZPX(struct rp2a03 *rp2a03);
-static inline void BCC(struct rp2a03 *rp2a03);
-static inline void BCS(struct rp2a03 *rp2a03);
-static inline void BEQ(struct rp2a03 *rp2a03);
+static inline uint8_t ASL(struct rp2a03 *rp2a03, uint8_t b);
 static inline void BIT(struct rp2a03 *rp2a03, uint8_t b);
-static inline void BIT_A(struct rp2a03 *rp2a03);
-static inline void BIT_ZP(struct rp2a03 *rp2a03);
-static inline void BMI(struct rp2a03 *rp2a03);
-static inline void BNE(struct rp2a03 *rp2a03);
-static inline void BPL(struct rp2a03 *rp2a03);
-static inline void BRK(struct rp2a03 *rp2a03);
-static inline void BVC(struct rp2a03 *rp2a03);
-static inline void BVS(struct rp2a03 *rp2a03);
-static inline void CLC(struct rp2a03 *rp2a03);
-static inline void CLD(struct rp2a03 *rp2a03);
-static inline void CLV(struct rp2a03 *rp2a03);
 static inline void CMP(struct rp2a03 *rp2a03, uint8_t b);
-static inline void CMP_A(struct rp2a03 *rp2a03);
-static inline void CMP_AX(struct rp2a03 *rp2a03);
-static inline void CMP_AY(struct rp2a03 *rp2a03);
-static inline void CMP_I(struct rp2a03 *rp2a03);
-static inline void CMP_IX(struct rp2a03 *rp2a03);
-static inline void CMP_IY(struct rp2a03 *rp2a03);
-static inline void CMP_ZP(struct rp2a03 *rp2a03);
-static inline void CMP_ZPX(struct rp2a03 *rp2a03);
 static inline void CPX(struct rp2a03 *rp2a03, uint8_t b);
-static inline void CPX_A(struct rp2a03 *rp2a03);
-static inline void CPX_I(struct rp2a03 *rp2a03);
-static inline void CPX_ZP(struct rp2a03 *rp2a03);
 static inline void CPY(struct rp2a03 *rp2a03, uint8_t b);
-static inline void CPY_A(struct rp2a03 *rp2a03);
-static inline void CPY_I(struct rp2a03 *rp2a03);
-static inline void CPY_ZP(struct rp2a03 *rp2a03);
-static inline void DEC(struct rp2a03 *rp2a03, uint16_t address);
-static inline void DEC_A(struct rp2a03 *rp2a03);
-static inline void DEC_AX(struct rp2a03 *rp2a03);
-static inline void DEC_ZP(struct rp2a03 *rp2a03);
-static inline void DEC_ZPX(struct rp2a03 *rp2a03);
-static inline void DEX(struct rp2a03 *rp2a03);
-static inline void DEY(struct rp2a03 *rp2a03);
+static inline uint8_t DEC(struct rp2a03 *rp2a03, uint8_t b);
 static inline void EOR(struct rp2a03 *rp2a03, uint8_t b);
-static inline void EOR_A(struct rp2a03 *rp2a03);
-static inline void EOR_AX(struct rp2a03 *rp2a03);
-static inline void EOR_AY(struct rp2a03 *rp2a03);
-static inline void EOR_I(struct rp2a03 *rp2a03);
-static inline void EOR_IX(struct rp2a03 *rp2a03);
-static inline void EOR_IY(struct rp2a03 *rp2a03);
-static inline void EOR_ZP(struct rp2a03 *rp2a03);
-static inline void EOR_ZPX(struct rp2a03 *rp2a03);
-static inline void INC(struct rp2a03 *rp2a03, uint16_t address);
-static inline void INC_A(struct rp2a03 *rp2a03);
-static inline void INC_AX(struct rp2a03 *rp2a03);
-static inline void INC_ZP(struct rp2a03 *rp2a03);
-static inline void INC_ZPX(struct rp2a03 *rp2a03);
-static inline void INX(struct rp2a03 *rp2a03);
-static inline void INY(struct rp2a03 *rp2a03);
-static inline void JMP(struct rp2a03 *rp2a03, uint16_t address);
-static inline void JMP_A(struct rp2a03 *rp2a03);
-static inline void JMP_I(struct rp2a03 *rp2a03);
-static inline void JSR(struct rp2a03 *rp2a03);
+static inline uint8_t INC(struct rp2a03 *rp2a03, uint8_t b);
 static inline void LDA(struct rp2a03 *rp2a03, uint8_t b);
-static inline void LDA_A(struct rp2a03 *rp2a03);
-static inline void LDA_AX(struct rp2a03 *rp2a03);
-static inline void LDA_AY(struct rp2a03 *rp2a03);
-static inline void LDA_I(struct rp2a03 *rp2a03);
-static inline void LDA_IX(struct rp2a03 *rp2a03);
-static inline void LDA_IY(struct rp2a03 *rp2a03);
-static inline void LDA_ZPX(struct rp2a03 *rp2a03);
-static inline void LDA_ZP(struct rp2a03 *rp2a03);
 static inline void LDX(struct rp2a03 *rp2a03, uint8_t b);
-static inline void LDX_A(struct rp2a03 *rp2a03);
-static inline void LDX_AY(struct rp2a03 *rp2a03);
-static inline void LDX_I(struct rp2a03 *rp2a03);
-static inline void LDX_ZP(struct rp2a03 *rp2a03);
-static inline void LDX_ZPY(struct rp2a03 *rp2a03);
 static inline void LDY(struct rp2a03 *rp2a03, uint8_t b);
-static inline void LDY_A(struct rp2a03 *rp2a03);
-static inline void LDY_AX(struct rp2a03 *rp2a03);
-static inline void LDY_I(struct rp2a03 *rp2a03);
-static inline void LDY_ZP(struct rp2a03 *rp2a03);
-static inline void LDY_ZPX(struct rp2a03 *rp2a03);
-static inline void LSR_ACC(struct rp2a03 *rp2a03);
-static inline void LSR_A(struct rp2a03 *rp2a03);
-static inline void LSR_AX(struct rp2a03 *rp2a03);
-static inline void LSR_ZP(struct rp2a03 *rp2a03);
-static inline void LSR_ZPX(struct rp2a03 *rp2a03);
+static inline uint8_t LSR(struct rp2a03 *rp2a03, uint8_t b);
+static inline void ORA(struct rp2a03 *rp2a03, uint8_t b);
+static inline uint8_t ROL(struct rp2a03 *rp2a03, uint8_t b);
+static inline uint8_t ROR(struct rp2a03 *rp2a03, uint8_t b);
+static inline void SBC(struct rp2a03 *rp2a03, uint8_t b);
+static inline void BRK(struct rp2a03 *rp2a03);
+static inline void JMP_A(struct rp2a03 *rp2a03);
+static inline void JMP_I(struct rp2a03 *rp2a03);
+static inline void JSR(struct rp2a03 *rp2a03);
 static inline void NOP(struct rp2a03 *rp2a03);
 static inline void NOP_A(struct rp2a03 *rp2a03);
 static inline void NOP_D(struct rp2a03 *rp2a03);
-static inline void ORA(struct rp2a03 *rp2a03, uint8_t b);
-static inline void ORA_A(struct rp2a03 *rp2a03);
-static inline void ORA_AX(struct rp2a03 *rp2a03);
-static inline void ORA_AY(struct rp2a03 *rp2a03);
-static inline void ORA_I(struct rp2a03 *rp2a03);
-static inline void ORA_IX(struct rp2a03 *rp2a03);
-static inline void ORA_IY(struct rp2a03 *rp2a03);
-static inline void ORA_ZP(struct rp2a03 *rp2a03);
-static inline void ORA_ZPX(struct rp2a03 *rp2a03);
 static inline void PHA(struct rp2a03 *rp2a03);
 static inline void PHP(struct rp2a03 *rp2a03);
 static inline void PLA(struct rp2a03 *rp2a03);
 static inline void PLP(struct rp2a03 *rp2a03);
-static inline void ROL_ACC(struct rp2a03 *rp2a03);
-static inline void ROL_A(struct rp2a03 *rp2a03);
-static inline void ROL_AX(struct rp2a03 *rp2a03);
-static inline void ROL_ZP(struct rp2a03 *rp2a03);
-static inline void ROL_ZPX(struct rp2a03 *rp2a03);
-static inline void ROR_ACC(struct rp2a03 *rp2a03);
-static inline void ROR_A(struct rp2a03 *rp2a03);
-static inline void ROR_AX(struct rp2a03 *rp2a03);
-static inline void ROR_ZP(struct rp2a03 *rp2a03);
-static inline void ROR_ZPX(struct rp2a03 *rp2a03);
 static inline void RTI(struct rp2a03 *rp2a03);
 static inline void RTS(struct rp2a03 *rp2a03);
-static inline void SBC_A(struct rp2a03 *rp2a03);
-static inline void SBC_AX(struct rp2a03 *rp2a03);
-static inline void SBC_AY(struct rp2a03 *rp2a03);
-static inline void SBC_I(struct rp2a03 *rp2a03);
-static inline void SBC_IX(struct rp2a03 *rp2a03);
-static inline void SBC_IY(struct rp2a03 *rp2a03);
-static inline void SBC_ZP(struct rp2a03 *rp2a03);
-static inline void SBC_ZPX(struct rp2a03 *rp2a03);
-static inline void SEC(struct rp2a03 *rp2a03);
-static inline void SED(struct rp2a03 *rp2a03);
-static inline void SEI(struct rp2a03 *rp2a03);
-static inline void STA_A(struct rp2a03 *rp2a03);
-static inline void STA_AX(struct rp2a03 *rp2a03);
-static inline void STA_AY(struct rp2a03 *rp2a03);
-static inline void STA_IX(struct rp2a03 *rp2a03);
-static inline void STA_IY(struct rp2a03 *rp2a03);
-static inline void STA_ZP(struct rp2a03 *rp2a03);
-static inline void STA_ZPX(struct rp2a03 *rp2a03);
-static inline void STX_A(struct rp2a03 *rp2a03);
-static inline void STX_ZP(struct rp2a03 *rp2a03);
-static inline void STX_ZPY(struct rp2a03 *rp2a03);
-static inline void STY_A(struct rp2a03 *rp2a03);
-static inline void STY_ZP(struct rp2a03 *rp2a03);
-static inline void STY_ZPX(struct rp2a03 *rp2a03);
-static inline void TAX(struct rp2a03 *rp2a03);
-static inline void TAY(struct rp2a03 *rp2a03);
-static inline void TSX(struct rp2a03 *rp2a03);
-static inline void TXA(struct rp2a03 *rp2a03);
 static inline void TXS(struct rp2a03 *rp2a03);
-static inline void TYA(struct rp2a03 *rp2a03);
+static inline void UNK(struct rp2a03 *rp2a03);
+
+#ifdef CONFIG_CPU_RP2A03_JIT
+/* Command-line parameter */
+static char *jit_mode_name;
+PARAM(jit_mode_name, string, "rp2a03-jit", NULL,
+	"Selects RP2A03 JIT mode (off or on)")
+#endif
 
-void ADC_A(struct rp2a03 *rp2a03)
+uint16_t ADDR_A(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
+	return rp2a03->operand;
 }
 
-void ADC_AX(struct rp2a03 *rp2a03)
+uint16_t ADDR_AX(struct rp2a03 *rp2a03)
 {
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
+	return ADDR_A(rp2a03) + rp2a03->X;
 }
 
-void ADC_AY(struct rp2a03 *rp2a03)
+uint16_t ADDR_AY(struct rp2a03 *rp2a03)
 {
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
+	return ADDR_A(rp2a03) + rp2a03->Y;
 }
 
-void ADC_I(struct rp2a03 *rp2a03)
+uint16_t ADDR_IX(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(2);
+	uint8_t b = rp2a03->operand + rp2a03->X;
+
+	/* Pointer is read from zero page (wrapping around) */
+	return memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
+		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
 }
 
-void ADC_IX(struct rp2a03 *rp2a03)
+uint16_t ADDR_IY(struct rp2a03 *rp2a03)
 {
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
+	uint8_t b = rp2a03->operand;
+	uint16_t address;
+
+	/* Pointer is read from zero page (wrapping around) */
+	address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
 		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(6);
+	return address + rp2a03->Y;
 }
 
-void ADC_IY(struct rp2a03 *rp2a03)
+uint16_t ADDR_ZP(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(5);
+	return rp2a03->operand;
 }
 
-void ADC_ZP(struct rp2a03 *rp2a03)
+uint16_t ADDR_ZPX(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	uint16_t result = rp2a03->A + b + rp2a03->C;
-	rp2a03->C = result >> 8;
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(3);
+	return (ADDR_ZP(rp2a03) + rp2a03->X) % ZP_SIZE;
+}
+
+uint16_t ADDR_ZPY(struct rp2a03 *rp2a03)
+{
+	return (ADDR_ZP(rp2a03) + rp2a03->Y) % ZP_SIZE;
 }
 
-void ADC_ZPX(struct rp2a03 *rp2a03)
+void ADC(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
 	uint16_t result = rp2a03->A + b + rp2a03->C;
 	rp2a03->C = result >> 8;
 	rp2a03->Z = ((uint8_t)result == 0);
 	rp2a03->V = ((~(rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
 	rp2a03->N = ((result & 0x80) != 0);
 	rp2a03->A = result;
-	clock_consume(4);
 }
 
 void AND(struct rp2a03 *rp2a03, uint8_t b)
@@ -326,219 +429,278 @@ void AND(struct rp2a03 *rp2a03, uint8_t b)
 	rp2a03->N = ((rp2a03->A & 0x80) != 0);
 }
 
-void AND_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	AND(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void AND_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	AND(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void AND_AY(struct rp2a03 *rp2a03)
+uint8_t ASL(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	AND(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
+	rp2a03->C = ((b & 0x80) != 0);
+	b <<= 1;
+	rp2a03->Z = (b == 0);
+	rp2a03->N = ((b & 0x80) != 0);
+	return b;
 }
 
-void AND_I(struct rp2a03 *rp2a03)
+void BIT(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	AND(rp2a03, b);
-	clock_consume(2);
+	rp2a03->Z = ((rp2a03->A & b) == 0);
+	rp2a03->V = ((b & 0x40) != 0);
+	rp2a03->N = ((b & 0x80) != 0);
 }
 
-void AND_IX(struct rp2a03 *rp2a03)
+void CMP(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	AND(rp2a03, b);
-	clock_consume(6);
+	rp2a03->C = (rp2a03->A >= b);
+	rp2a03->Z = (rp2a03->A == b);
+	rp2a03->N = (((rp2a03->A - b) & 0x80) != 0);
 }
 
-void AND_IY(struct rp2a03 *rp2a03)
+void CPX(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	AND(rp2a03, b);
-	clock_consume(5);
+	rp2a03->C = (rp2a03->X >= b);
+	rp2a03->Z = (rp2a03->X == b);
+	rp2a03->N = (((rp2a03->X - b) & 0x80) != 0);
 }
 
-void AND_ZP(struct rp2a03 *rp2a03)
+void CPY(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	AND(rp2a03, b);
-	clock_consume(3);
+	rp2a03->C = (rp2a03->Y >= b);
+	rp2a03->Z = (rp2a03->Y == b);
+	rp2a03->N = (((rp2a03->Y - b) & 0x80) != 0);
 }
 
-void AND_ZPX(struct rp2a03 *rp2a03)
+uint8_t DEC(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	AND(rp2a03, b);
-	clock_consume(4);
+	b--;
+	rp2a03->Z = (b == 0);
+	rp2a03->N = ((b & 0x80) != 0);
+	return b;
 }
 
-void ASL_ACC(struct rp2a03 *rp2a03)
+void EOR(struct rp2a03 *rp2a03, uint8_t b)
 {
-	rp2a03->C = ((rp2a03->A & 0x80) != 0);
-	rp2a03->A <<= 1;
+	rp2a03->A ^= b;
 	rp2a03->Z = (rp2a03->A == 0);
 	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(2);
-}
-
-void ASL_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x80) != 0);
-	b <<= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(6);
 }
 
-void ASL_AX(struct rp2a03 *rp2a03)
+uint8_t INC(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x80) != 0);
-	b <<= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
+	b++;
 	rp2a03->Z = (b == 0);
 	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(7);
+	return b;
 }
 
-void ASL_ZP(struct rp2a03 *rp2a03)
+void LDA(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x80) != 0);
-	b <<= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(5);
+	rp2a03->A = b;
+	rp2a03->Z = (rp2a03->A == 0);
+	rp2a03->N = ((rp2a03->A & 0x80) != 0);
 }
 
-void ASL_ZPX(struct rp2a03 *rp2a03)
+void LDX(struct rp2a03 *rp2a03, uint8_t b)
 {
-	uint8_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x80) != 0);
-	b <<= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(6);
+	rp2a03->X = b;
+	rp2a03->Z = (rp2a03->X == 0);
+	rp2a03->N = ((rp2a03->X & 0x80) != 0);
 }
 
-void BCC(struct rp2a03 *rp2a03)
+void LDY(struct rp2a03 *rp2a03, uint8_t b)
 {
-	if (!rp2a03->C) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	rp2a03->Y = b;
+	rp2a03->Z = (rp2a03->Y == 0);
+	rp2a03->N = ((rp2a03->Y & 0x80) != 0);
 }
 
-void BCS(struct rp2a03 *rp2a03)
+uint8_t LSR(struct rp2a03 *rp2a03, uint8_t b)
 {
-	if (rp2a03->C) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	rp2a03->C = ((b & 0x01) != 0);
+	b >>= 1;
+	rp2a03->Z = (b == 0);
+	rp2a03->N = 0;
+	return b;
 }
 
-void BEQ(struct rp2a03 *rp2a03)
+void ORA(struct rp2a03 *rp2a03, uint8_t b)
 {
-	if (rp2a03->Z) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	rp2a03->A |= b;
+	rp2a03->Z = (rp2a03->A == 0);
+	rp2a03->N = ((rp2a03->A & 0x80) != 0);
 }
 
-void BIT(struct rp2a03 *rp2a03, uint8_t b)
+uint8_t ROL(struct rp2a03 *rp2a03, uint8_t b)
 {
-	rp2a03->Z = ((rp2a03->A & b) == 0);
-	rp2a03->V = ((b & 0x40) != 0);
+	uint8_t old_carry = rp2a03->C;
+	rp2a03->C = ((b & 0x80) != 0);
+	b = (b << 1) | old_carry;
+	rp2a03->Z = (b == 0);
 	rp2a03->N = ((b & 0x80) != 0);
+	return b;
 }
 
-void BIT_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	BIT(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void BIT_ZP(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	BIT(rp2a03, b);
-	clock_consume(3);
-}
-
-void BMI(struct rp2a03 *rp2a03)
+uint8_t ROR(struct rp2a03 *rp2a03, uint8_t b)
 {
-	if (rp2a03->N) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	uint8_t old_carry = rp2a03->C;
+	rp2a03->C = ((b & 0x01) != 0);
+	b = (b >> 1) | (old_carry << 7);
+	rp2a03->Z = (b == 0);
+	rp2a03->N = ((b & 0x80) != 0);
+	return b;
 }
 
-void BNE(struct rp2a03 *rp2a03)
+void SBC(struct rp2a03 *rp2a03, uint8_t b)
 {
-	if (!rp2a03->Z) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
+	rp2a03->C = ~(result >> 8);
+	rp2a03->Z = ((uint8_t)result == 0);
+	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
+	rp2a03->N = ((result & 0x80) != 0);
+	rp2a03->A = result;
 }
 
-void BPL(struct rp2a03 *rp2a03)
-{
-	if (!rp2a03->N) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
-}
+READ_INSTRUCTION(ADC, A, 4)
+READ_INSTRUCTION(ADC, AX, 4)
+READ_INSTRUCTION(ADC, AY, 4)
+IMM_INSTRUCTION(ADC)
+READ_INSTRUCTION(ADC, IX, 6)
+READ_INSTRUCTION(ADC, IY, 5)
+READ_INSTRUCTION(ADC, ZP, 3)
+READ_INSTRUCTION(ADC, ZPX, 4)
+READ_INSTRUCTION(AND, A, 4)
+READ_INSTRUCTION(AND, AX, 4)
+READ_INSTRUCTION(AND, AY, 4)
+IMM_INSTRUCTION(AND)
+READ_INSTRUCTION(AND, IX, 6)
+READ_INSTRUCTION(AND, IY, 5)
+READ_INSTRUCTION(AND, ZP, 3)
+READ_INSTRUCTION(AND, ZPX, 4)
+READ_INSTRUCTION(BIT, A, 4)
+READ_INSTRUCTION(BIT, ZP, 3)
+READ_INSTRUCTION(CMP, A, 4)
+READ_INSTRUCTION(CMP, AX, 4)
+READ_INSTRUCTION(CMP, AY, 6)
+IMM_INSTRUCTION(CMP)
+READ_INSTRUCTION(CMP, IX, 6)
+READ_INSTRUCTION(CMP, IY, 5)
+READ_INSTRUCTION(CMP, ZP, 3)
+READ_INSTRUCTION(CMP, ZPX, 4)
+READ_INSTRUCTION(CPX, A, 4)
+IMM_INSTRUCTION(CPX)
+READ_INSTRUCTION(CPX, ZP, 3)
+READ_INSTRUCTION(CPY, A, 4)
+IMM_INSTRUCTION(CPY)
+READ_INSTRUCTION(CPY, ZP, 3)
+READ_INSTRUCTION(EOR, A, 4)
+READ_INSTRUCTION(EOR, AX, 4)
+READ_INSTRUCTION(EOR, AY, 4)
+IMM_INSTRUCTION(EOR)
+READ_INSTRUCTION(EOR, IX, 6)
+READ_INSTRUCTION(EOR, IY, 5)
+READ_INSTRUCTION(EOR, ZP, 3)
+READ_INSTRUCTION(EOR, ZPX, 4)
+READ_INSTRUCTION(LDA, A, 4)
+READ_INSTRUCTION(LDA, AX, 4)
+READ_INSTRUCTION(LDA, AY, 4)
+IMM_INSTRUCTION(LDA)
+READ_INSTRUCTION(LDA, IX, 5)
+READ_INSTRUCTION(LDA, IY, 5)
+READ_INSTRUCTION(LDA, ZP, 3)
+READ_INSTRUCTION(LDA, ZPX, 4)
+READ_INSTRUCTION(LDX, A, 4)
+READ_INSTRUCTION(LDX, AY, 4)
+IMM_INSTRUCTION(LDX)
+READ_INSTRUCTION(LDX, ZP, 3)
+READ_INSTRUCTION(LDX, ZPY, 4)
+READ_INSTRUCTION(LDY, A, 4)
+READ_INSTRUCTION(LDY, AX, 4)
+IMM_INSTRUCTION(LDY)
+READ_INSTRUCTION(LDY, ZP, 3)
+READ_INSTRUCTION(LDY, ZPX, 4)
+READ_INSTRUCTION(ORA, A, 4)
+READ_INSTRUCTION(ORA, AX, 4)
+READ_INSTRUCTION(ORA, AY, 4)
+IMM_INSTRUCTION(ORA)
+READ_INSTRUCTION(ORA, IX, 6)
+READ_INSTRUCTION(ORA, IY, 5)
+READ_INSTRUCTION(ORA, ZP, 3)
+READ_INSTRUCTION(ORA, ZPX, 4)
+READ_INSTRUCTION(SBC, A, 4)
+READ_INSTRUCTION(SBC, AX, 4)
+READ_INSTRUCTION(SBC, AY, 4)
+IMM_INSTRUCTION(SBC)
+READ_INSTRUCTION(SBC, IX, 6)
+READ_INSTRUCTION(SBC, IY, 5)
+READ_INSTRUCTION(SBC, ZP, 3)
+READ_INSTRUCTION(SBC, ZPX, 4)
+
+RMW_INSTRUCTION(ASL, A, 6)
+RMW_INSTRUCTION(ASL, AX, 7)
+RMW_INSTRUCTION(ASL, ZP, 5)
+RMW_INSTRUCTION(ASL, ZPX, 6)
+RMW_INSTRUCTION(DEC, A, 6)
+RMW_INSTRUCTION(DEC, AX, 7)
+RMW_INSTRUCTION(DEC, ZP, 5)
+RMW_INSTRUCTION(DEC, ZPX, 6)
+RMW_INSTRUCTION(INC, A, 6)
+RMW_INSTRUCTION(INC, AX, 7)
+RMW_INSTRUCTION(INC, ZP, 5)
+RMW_INSTRUCTION(INC, ZPX, 6)
+RMW_INSTRUCTION(LSR, A, 6)
+RMW_INSTRUCTION(LSR, AX, 7)
+RMW_INSTRUCTION(LSR, ZP, 5)
+RMW_INSTRUCTION(LSR, ZPX, 6)
+RMW_INSTRUCTION(ROL, A, 6)
+RMW_INSTRUCTION(ROL, AX, 7)
+RMW_INSTRUCTION(ROL, ZP, 5)
+RMW_INSTRUCTION(ROL, ZPX, 6)
+RMW_INSTRUCTION(ROR, A, 6)
+RMW_INSTRUCTION(ROR, AX, 7)
+RMW_INSTRUCTION(ROR, ZP, 5)
+RMW_INSTRUCTION(ROR, ZPX, 6)
+
+ACC_INSTRUCTION(ASL)
+ACC_INSTRUCTION(LSR)
+ACC_INSTRUCTION(ROL)
+ACC_INSTRUCTION(ROR)
+
+STORE_INSTRUCTION(STA, A, A, 4)
+STORE_INSTRUCTION(STA, A, AX, 5)
+STORE_INSTRUCTION(STA, A, AY, 5)
+STORE_INSTRUCTION(STA, A, IX, 6)
+STORE_INSTRUCTION(STA, A, IY, 6)
+STORE_INSTRUCTION(STA, A, ZP, 3)
+STORE_INSTRUCTION(STA, A, ZPX, 4)
+STORE_INSTRUCTION(STX, X, A, 4)
+STORE_INSTRUCTION(STX, X, ZP, 3)
+STORE_INSTRUCTION(STX, X, ZPY, 4)
+STORE_INSTRUCTION(STY, Y, A, 4)
+STORE_INSTRUCTION(STY, Y, ZP, 3)
+STORE_INSTRUCTION(STY, Y, ZPX, 4)
+
+BRANCH_INSTRUCTION(BCC, !rp2a03->C)
+BRANCH_INSTRUCTION(BCS, rp2a03->C)
+BRANCH_INSTRUCTION(BEQ, rp2a03->Z)
+BRANCH_INSTRUCTION(BMI, rp2a03->N)
+BRANCH_INSTRUCTION(BNE, !rp2a03->Z)
+BRANCH_INSTRUCTION(BPL, !rp2a03->N)
+BRANCH_INSTRUCTION(BVC, !rp2a03->V)
+BRANCH_INSTRUCTION(BVS, rp2a03->V)
+
+FLAG_INSTRUCTION(CLC, C, 0)
+FLAG_INSTRUCTION(CLD, D, 0)
+FLAG_INSTRUCTION(CLV, V, 0)
+FLAG_INSTRUCTION(SEC, C, 1)
+FLAG_INSTRUCTION(SED, D, 1)
+FLAG_INSTRUCTION(SEI, I, 1)
+
+TRANSFER_INSTRUCTION(TAX, A, X)
+TRANSFER_INSTRUCTION(TAY, A, Y)
+TRANSFER_INSTRUCTION(TSX, S, X)
+TRANSFER_INSTRUCTION(TXA, X, A)
+TRANSFER_INSTRUCTION(TYA, Y, A)
+
+STEP_INSTRUCTION(DEX, X, -1)
+STEP_INSTRUCTION(DEY, Y, -1)
+STEP_INSTRUCTION(INX, X, 1)
+STEP_INSTRUCTION(INY, Y, 1)
 
 void BRK(struct rp2a03 *rp2a03)
 {
@@ -560,887 +722,82 @@ void BRK(struct rp2a03 *rp2a03)
 	clock_consume(7);
 }
 
-void BVC(struct rp2a03 *rp2a03)
+void JMP_A(struct rp2a03 *rp2a03)
 {
-	if (!rp2a03->V) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	rp2a03->PC = rp2a03->operand;
+	clock_consume(3);
 }
 
-void BVS(struct rp2a03 *rp2a03)
+void JMP_I(struct rp2a03 *rp2a03)
 {
-	if (rp2a03->V) {
-		rp2a03->PC += (int8_t)memory_readb(rp2a03->bus_id, rp2a03->PC);
-		clock_consume(1);
-	}
-	rp2a03->PC++;
-	clock_consume(2);
+	uint16_t address_1 = rp2a03->operand;
+	uint16_t address_2 = ((address_1 + 1) & 0xFF) | (address_1 & 0xFF00);
+	rp2a03->PC = memory_readb(rp2a03->bus_id, address_1) |
+		(memory_readb(rp2a03->bus_id, address_2) << 8);
+	clock_consume(5);
 }
 
-void CLC(struct rp2a03 *rp2a03)
+void JSR(struct rp2a03 *rp2a03)
 {
-	rp2a03->C = 0;
-	clock_consume(2);
-}
+	/* Return address points to last byte of instruction */
+	memory_writeb(rp2a03->bus_id, (rp2a03->PC - 1) >> 8,
+		STACK_START + rp2a03->S--);
+	memory_writeb(rp2a03->bus_id, (rp2a03->PC - 1) & 0xFF,
+		STACK_START + rp2a03->S--);
 
-void CLD(struct rp2a03 *rp2a03)
-{
-	rp2a03->D = 0;
-	clock_consume(2);
-}
+	/* Target high byte is fetched after pushing (and may be overwritten
+	when running from the stack page) */
+	if (((rp2a03->PC - 1) & 0xFF00) == STACK_START)
+		rp2a03->operand = (rp2a03->operand & 0xFF) |
+			(memory_readb(rp2a03->bus_id, rp2a03->PC - 1) << 8);
 
-void CLV(struct rp2a03 *rp2a03)
-{
-	rp2a03->V = 0;
-	clock_consume(2);
+	rp2a03->PC = rp2a03->operand;
+	clock_consume(6);
 }
 
-void CMP(struct rp2a03 *rp2a03, uint8_t b)
+void NOP(struct rp2a03 *UNUSED(rp2a03))
 {
-	rp2a03->C = (rp2a03->A >= b);
-	rp2a03->Z = (rp2a03->A == b);
-	rp2a03->N = (((rp2a03->A - b) & 0x80) != 0);
+	clock_consume(2);
 }
 
-void CMP_A(struct rp2a03 *rp2a03)
+void NOP_A(struct rp2a03 *UNUSED(rp2a03))
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	CMP(rp2a03, b);
-	rp2a03->PC += 2;
 	clock_consume(4);
 }
 
-void CMP_AX(struct rp2a03 *rp2a03)
+void NOP_D(struct rp2a03 *UNUSED(rp2a03))
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->X);
-	CMP(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
+	clock_consume(3);
 }
 
-void CMP_AY(struct rp2a03 *rp2a03)
+void PHA(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->Y);
-	CMP(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(6);
+	memory_writeb(rp2a03->bus_id, rp2a03->A, STACK_START + rp2a03->S--);
+	clock_consume(3);
 }
 
-void CMP_I(struct rp2a03 *rp2a03)
+void PHP(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	CMP(rp2a03, b);
-	clock_consume(2);
+	rp2a03->B = 1;
+	memory_writeb(rp2a03->bus_id, rp2a03->P, STACK_START + rp2a03->S--);
+	rp2a03->B = 0;
+	clock_consume(3);
 }
 
-void CMP_IX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	CMP(rp2a03, b);
-	clock_consume(6);
-}
-
-void CMP_IY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	CMP(rp2a03, b);
-	clock_consume(5);
-}
-
-void CMP_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	CMP(rp2a03, b);
-	clock_consume(3);
-}
-
-void CMP_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	CMP(rp2a03, b);
-	clock_consume(4);
-}
-
-void CPX(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->C = (rp2a03->X >= b);
-	rp2a03->Z = (rp2a03->X == b);
-	rp2a03->N = (((rp2a03->X - b) & 0x80) != 0);
-}
-
-void CPX_A(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	CPX(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void CPX_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	CPX(rp2a03, b);
-	clock_consume(2);
-}
-
-void CPX_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	CPX(rp2a03, b);
-	clock_consume(3);
-}
-
-void CPY(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->C = (rp2a03->Y >= b);
-	rp2a03->Z = (rp2a03->Y == b);
-	rp2a03->N = (((rp2a03->Y - b) & 0x80) != 0);
-}
-
-void CPY_A(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	CPY(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void CPY_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	CPY(rp2a03, b);
-	clock_consume(2);
-}
-
-void CPY_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	CPY(rp2a03, b);
-	clock_consume(3);
-}
-
-void DEC(struct rp2a03 *rp2a03, uint16_t address)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, address) - 1;
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	memory_writeb(rp2a03->bus_id, b, address);
-}
-
-void DEC_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	DEC(rp2a03, address);
-	rp2a03->PC += 2;
-	clock_consume(6);
-}
-
-void DEC_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	DEC(rp2a03, address);
-	rp2a03->PC += 2;
-	clock_consume(7);
-}
-
-void DEC_ZP(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	DEC(rp2a03, address);
-	clock_consume(5);
-}
-
-void DEC_ZPX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	DEC(rp2a03, address);
-	clock_consume(6);
-}
-
-void DEX(struct rp2a03 *rp2a03)
-{
-	rp2a03->X--;
-	rp2a03->Z = (rp2a03->X == 0);
-	rp2a03->N = ((rp2a03->X & 0x80) != 0);
-	clock_consume(2);
-}
-
-void DEY(struct rp2a03 *rp2a03)
-{
-	rp2a03->Y--;
-	rp2a03->Z = (rp2a03->Y == 0);
-	rp2a03->N = ((rp2a03->Y & 0x80) != 0);
-	clock_consume(2);
-}
-
-void EOR(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->A ^= b;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-}
-
-void EOR_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	EOR(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void EOR_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	EOR(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void EOR_AY(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	EOR(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void EOR_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	EOR(rp2a03, b);
-	clock_consume(2);
-}
-
-void EOR_IX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	EOR(rp2a03, b);
-	clock_consume(6);
-}
-
-void EOR_IY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	EOR(rp2a03, b);
-	clock_consume(5);
-}
-
-void EOR_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	EOR(rp2a03, b);
-	clock_consume(3);
-}
-
-void EOR_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	EOR(rp2a03, b);
-	clock_consume(4);
-}
-
-void INC(struct rp2a03 *rp2a03, uint16_t address)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, address) + 1;
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	memory_writeb(rp2a03->bus_id, b, address);
-}
-
-void INC_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	INC(rp2a03, address);
-	rp2a03->PC += 2;
-	clock_consume(6);
-}
-
-void INC_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	INC(rp2a03, address);
-	rp2a03->PC += 2;
-	clock_consume(7);
-}
-
-void INC_ZP(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	INC(rp2a03, address);
-	clock_consume(5);
-}
-
-void INC_ZPX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	INC(rp2a03, address);
-	clock_consume(6);
-}
-
-void INX(struct rp2a03 *rp2a03)
-{
-	rp2a03->X++;
-	rp2a03->Z = (rp2a03->X == 0);
-	rp2a03->N = ((rp2a03->X & 0x80) != 0);
-	clock_consume(2);
-}
-
-void INY(struct rp2a03 *rp2a03)
-{
-	rp2a03->Y++;
-	rp2a03->Z = (rp2a03->Y == 0);
-	rp2a03->N = ((rp2a03->Y & 0x80) != 0);
-	clock_consume(2);
-}
-
-void JMP(struct rp2a03 *rp2a03, uint16_t address)
-{
-	rp2a03->PC = address;
-}
-
-void JMP_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	JMP(rp2a03, address);
-	clock_consume(3);
-}
-
-void JMP_I(struct rp2a03 *rp2a03)
-{
-	uint16_t address_1 = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint16_t address_2 = ((address_1 + 1) & 0xFF) | (address_1 & 0xFF00);
-	uint16_t address = memory_readb(rp2a03->bus_id, address_1) |
-		(memory_readb(rp2a03->bus_id, address_2) << 8);
-	JMP(rp2a03, address);
-	clock_consume(5);
-}
-
-void JSR(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, (rp2a03->PC + 1) >> 8,
-		STACK_START + rp2a03->S--);
-	memory_writeb(rp2a03->bus_id, (rp2a03->PC + 1) & 0xFF,
-		STACK_START + rp2a03->S--);
-	rp2a03->PC = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	clock_consume(6);
-}
-
-void LDA(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->A = b;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-}
-
-void LDA_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDA_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDA_AY(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDA_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	LDA(rp2a03, b);
-	clock_consume(2);
-}
-
-void LDA_IX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	LDA(rp2a03, b);
-	clock_consume(5);
-}
-
-void LDA_IY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	LDA(rp2a03, b);
-	clock_consume(5);
-}
-
-void LDA_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	LDA(rp2a03, b);
-	clock_consume(4);
-}
-
-void LDA_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	LDA(rp2a03, b);
-	clock_consume(3);
-}
-
-void LDX(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->X = b;
-	rp2a03->Z = (rp2a03->X == 0);
-	rp2a03->N = ((rp2a03->X & 0x80) != 0);
-}
-
-void LDX_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDX(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDX_AY(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDX(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDX_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	LDX(rp2a03, b);
-	clock_consume(2);
-}
-
-void LDX_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	LDX(rp2a03, b);
-	clock_consume(3);
-}
-
-void LDX_ZPY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->Y) % ZP_SIZE);
-	LDX(rp2a03, b);
-	clock_consume(4);
-}
-
-void LDY(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->Y = b;
-	rp2a03->Z = (rp2a03->Y == 0);
-	rp2a03->N = ((rp2a03->Y & 0x80) != 0);
-}
-
-void LDY_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDY(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDY_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	LDY(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void LDY_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	LDY(rp2a03, b);
-	clock_consume(2);
-}
-
-void LDY_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	LDY(rp2a03, b);
-	clock_consume(3);
-}
-
-void LDY_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	LDY(rp2a03, b);
-	clock_consume(4);
-}
-
-void LSR_ACC(struct rp2a03 *rp2a03)
-{
-	rp2a03->C = ((rp2a03->A & 0x01) != 0);
-	rp2a03->A >>= 1;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = 0;
-	clock_consume(2);
-}
-
-void LSR_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x01) != 0);
-	b >>= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = 0;
-	rp2a03->PC += 2;
-	clock_consume(6);
-}
-
-void LSR_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x01) != 0);
-	b >>= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = 0;
-	rp2a03->PC += 2;
-	clock_consume(7);
-}
-
-void LSR_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x01) != 0);
-	b >>= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = 0;
-	clock_consume(5);
-}
-
-void LSR_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	rp2a03->C = ((b & 0x01) != 0);
-	b >>= 1;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = 0;
-	clock_consume(6);
-}
-
-void NOP(struct rp2a03 *UNUSED(rp2a03))
-{
-	clock_consume(2);
-}
-
-void NOP_A(struct rp2a03 *rp2a03)
-{
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void NOP_D(struct rp2a03 *rp2a03)
-{
-	rp2a03->PC++;
-	clock_consume(3);
-}
-
-void ORA(struct rp2a03 *rp2a03, uint8_t b)
-{
-	rp2a03->A |= b;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-}
-
-void ORA_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	ORA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void ORA_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	ORA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void ORA_AY(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->Y;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	ORA(rp2a03, b);
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
-
-void ORA_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	ORA(rp2a03, b);
-	clock_consume(2);
-}
-
-void ORA_IX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	ORA(rp2a03, b);
-	clock_consume(6);
-}
-
-void ORA_IY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	ORA(rp2a03, b);
-	clock_consume(5);
-}
-
-void ORA_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	ORA(rp2a03, b);
-	clock_consume(3);
-}
-
-void ORA_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	ORA(rp2a03, b);
-	clock_consume(4);
-}
-
-void PHA(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->A, STACK_START + rp2a03->S--);
-	clock_consume(3);
-}
-
-void PHP(struct rp2a03 *rp2a03)
-{
-	rp2a03->B = 1;
-	memory_writeb(rp2a03->bus_id, rp2a03->P, STACK_START + rp2a03->S--);
-	rp2a03->B = 0;
-	clock_consume(3);
-}
-
-void PLA(struct rp2a03 *rp2a03)
-{
-	rp2a03->A = memory_readb(rp2a03->bus_id, STACK_START + ++rp2a03->S);
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(4);
-}
-
-void PLP(struct rp2a03 *rp2a03)
-{
-	rp2a03->P = memory_readb(rp2a03->bus_id, STACK_START + ++rp2a03->S);
-	rp2a03->unused = 1;
-	rp2a03->B = 0;
-	clock_consume(4);
-}
-
-void ROL_ACC(struct rp2a03 *rp2a03)
-{
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((rp2a03->A & 0x80) != 0);
-	rp2a03->A = (rp2a03->A << 1) | old_carry;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(2);
-}
-
-void ROL_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x80) != 0);
-	b = (b << 1) | old_carry;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(6);
-}
-
-void ROL_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x80) != 0);
-	b = (b << 1) | old_carry;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(7);
-}
-
-void ROL_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x80) != 0);
-	b = (b << 1) | old_carry;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(5);
-}
-
-void ROL_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x80) != 0);
-	b = (b << 1) | old_carry;
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(6);
-}
-
-void ROR_ACC(struct rp2a03 *rp2a03)
+void PLA(struct rp2a03 *rp2a03)
 {
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((rp2a03->A & 0x01) != 0);
-	rp2a03->A = (rp2a03->A >> 1) | (old_carry << 7);
+	rp2a03->A = memory_readb(rp2a03->bus_id, STACK_START + ++rp2a03->S);
 	rp2a03->Z = (rp2a03->A == 0);
 	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(2);
-}
-
-void ROR_A(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x01) != 0);
-	b = (b >> 1) | (old_carry << 7);
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(6);
-}
-
-void ROR_AX(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id, rp2a03->PC) + rp2a03->X;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x01) != 0);
-	b = (b >> 1) | (old_carry << 7);
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	rp2a03->PC += 2;
-	clock_consume(7);
-}
-
-void ROR_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t address = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x01) != 0);
-	b = (b >> 1) | (old_carry << 7);
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(5);
+	clock_consume(4);
 }
 
-void ROR_ZPX(struct rp2a03 *rp2a03)
+void PLP(struct rp2a03 *rp2a03)
 {
-	uint8_t address = (memory_readb(rp2a03->bus_id, rp2a03->PC++) +
-		rp2a03->X) % ZP_SIZE;
-	uint8_t b = memory_readb(rp2a03->bus_id, address);
-	uint8_t old_carry = rp2a03->C;
-	rp2a03->C = ((b & 0x01) != 0);
-	b = (b >> 1) | (old_carry << 7);
-	memory_writeb(rp2a03->bus_id, b, address);
-	rp2a03->Z = (b == 0);
-	rp2a03->N = ((b & 0x80) != 0);
-	clock_consume(6);
+	rp2a03->P = memory_readb(rp2a03->bus_id, STACK_START + ++rp2a03->S);
+	rp2a03->unused = 1;
+	rp2a03->B = 0;
+	clock_consume(4);
 }
 
 void RTI(struct rp2a03 *rp2a03)
@@ -1462,782 +819,410 @@ void RTS(struct rp2a03 *rp2a03)
 	clock_consume(6);
 }
 
-void SBC_A(struct rp2a03 *rp2a03)
+void TXS(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
+	rp2a03->S = rp2a03->X;
+	clock_consume(2);
 }
 
-void SBC_AX(struct rp2a03 *rp2a03)
+void UNK(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->X);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
+	uint8_t opcode = memory_readb(rp2a03->bus_id, rp2a03->PC - 1);
+	LOG_W("rp2a03: unknown opcode (%02x)!\n", opcode);
+	clock_consume(1);
 }
 
-void SBC_AY(struct rp2a03 *rp2a03)
+void rp2a03_nmi(struct rp2a03 *rp2a03)
 {
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->Y);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
+	/* Save PC */
+	memory_writeb(rp2a03->bus_id, rp2a03->PC >> 8, STACK_START +
+		rp2a03->S--);
+	memory_writeb(rp2a03->bus_id, rp2a03->PC & 0xFF, STACK_START +
+		rp2a03->S--);
 
-void SBC_I(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(2);
-}
+	/* Push flags */
+	memory_writeb(rp2a03->bus_id, rp2a03->P, STACK_START + rp2a03->S--);
 
-void SBC_IX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(6);
-}
+	/* Interrupt is now active */
+	rp2a03->I = 1;
 
-void SBC_IY(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, rp2a03->PC++);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	b = memory_readb(rp2a03->bus_id, address + rp2a03->Y);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(5);
-}
+	/* Set PC to value written at the interrupt vector address */
+	rp2a03->PC = memory_readw(rp2a03->bus_id, NMI_VECTOR);
+	clock_consume(7);
 
-void SBC_ZP(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(3);
+	/* Interrupt is now being handled */
+	rp2a03->interrupted = false;
 }
 
-void SBC_ZPX(struct rp2a03 *rp2a03)
-{
-	uint8_t b = memory_readb(rp2a03->bus_id, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	int16_t result = rp2a03->A - b - (1 - rp2a03->C);
-	rp2a03->C = ~(result >> 8);
-	rp2a03->Z = ((uint8_t)result == 0);
-	rp2a03->V = (((rp2a03->A ^ b) & (rp2a03->A ^ result) & 0x80) != 0);
-	rp2a03->N = ((result & 0x80) != 0);
-	rp2a03->A = result;
-	clock_consume(4);
-}
+/* Instruction length table */
+#define OPCODE_LENGTH(opcode, handler, length) \
+	[opcode] = length,
+static const uint8_t rp2a03_lengths[256] = {
+	RP2A03_OPCODES(OPCODE_LENGTH)
+};
 
-void SEC(struct rp2a03 *rp2a03)
+bool rp2a03_cacheable(struct bus *bus, uint16_t address)
 {
-	rp2a03->C = 1;
-	clock_consume(2);
-}
+	struct page *page;
 
-void SED(struct rp2a03 *rp2a03)
-{
-	rp2a03->D = 1;
-	clock_consume(2);
+	/* Only plain read-only memory (not writable or MMIO) can be cached */
+	page = memory_bus_page(bus, address & bus->mask);
+	return page->read_mem && !page->write_mem;
 }
 
-void SEI(struct rp2a03 *rp2a03)
+struct rp2a03_cache_page *rp2a03_cache_get(struct rp2a03 *rp2a03,
+	uint16_t address)
 {
-	rp2a03->I = 1;
-	clock_consume(2);
-}
+	struct bus *bus = &busses[rp2a03->bus_id];
+	struct rp2a03_cache_page *cache_page;
 
-void STA_A(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->A, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
+	/* Allocate cache page if needed and flush it if page table changed */
+	cache_page = rp2a03->cache[address >> BUS_PAGE_BITS];
+	if (!cache_page) {
+		cache_page = calloc(1, sizeof(struct rp2a03_cache_page));
+		rp2a03->cache[address >> BUS_PAGE_BITS] = cache_page;
+	} else if (cache_page->generation != bus->generation) {
+		memset(cache_page, 0, sizeof(struct rp2a03_cache_page));
+	}
+	cache_page->generation = bus->generation;
+	return cache_page;
+}
+
+uint8_t rp2a03_fetch(struct rp2a03 *rp2a03)
+{
+	struct bus *bus = &busses[rp2a03->bus_id];
+	struct rp2a03_cache_page *cache_page;
+	struct rp2a03_decoded *decoded;
+
+	/* Use cached instruction unless page table changed since decoding */
+	cache_page = rp2a03->cache[rp2a03->PC >> BUS_PAGE_BITS];
+	if (cache_page && (cache_page->generation == bus->generation)) {
+		decoded = &cache_page->entries[rp2a03->PC & BUS_PAGE_MASK];
+		if (decoded->length) {
+			rp2a03->operand = decoded->operand;
+			rp2a03->PC += decoded->length;
+			bus->open_bus = decoded->open_bus;
+			return decoded->opcode;
+		}
+	}
 
-void STA_AX(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->A, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->X);
-	rp2a03->PC += 2;
-	clock_consume(5);
+	/* Decode instruction from memory */
+	return rp2a03_decode(rp2a03);
 }
 
-void STA_AY(struct rp2a03 *rp2a03)
+uint8_t rp2a03_decode(struct rp2a03 *rp2a03)
 {
-	memory_writeb(rp2a03->bus_id, rp2a03->A, memory_readw(rp2a03->bus_id,
-		rp2a03->PC) + rp2a03->Y);
-	rp2a03->PC += 2;
-	clock_consume(5);
-}
+	struct bus *bus = &busses[rp2a03->bus_id];
+	struct rp2a03_cache_page *cache_page;
+	struct rp2a03_decoded *decoded;
+	uint16_t address = rp2a03->PC;
+	uint8_t opcode;
+	uint8_t length;
+
+	/* Fetch opcode and operand bytes, pointing PC to next instruction */
+	opcode = memory_fetchb(rp2a03->bus_id, address);
+	length = rp2a03_lengths[opcode];
+	if (length == 2)
+		rp2a03->operand = memory_readb(rp2a03->bus_id, address + 1);
+	else if (length == 3)
+		rp2a03->operand = memory_readw(rp2a03->bus_id, address + 1);
+	rp2a03->PC += length;
+
+	/* Leave already if instruction is not located in read-only memory */
+	if (!rp2a03_cacheable(bus, address) ||
+		!rp2a03_cacheable(bus, address + length - 1))
+		return opcode;
+
+	/* Cache decoded instruction */
+	cache_page = rp2a03_cache_get(rp2a03, address);
+	decoded = &cache_page->entries[address & BUS_PAGE_MASK];
+	decoded->operand = rp2a03->operand;
+	decoded->opcode = opcode;
+	decoded->length = length;
+	decoded->open_bus = bus->open_bus;
+	return opcode;
+}
+
+#ifdef CONFIG_CPU_RP2A03_THREADED
+
+/* Handler label generation (each handler jumps straight to the next one) */
+#define OPCODE_LABEL(opcode, handler, length) \
+	[opcode] = &&op_##opcode,
+#define OPCODE_BLOCK(opcode, handler, length) \
+	op_##opcode: \
+		handler(rp2a03); \
+		DISPATCH();
+
+/* Run next instruction unless another clock is due */
+#define DISPATCH() \
+	do { \
+		if (!clock_run_ahead()) \
+			return; \
+		if (rp2a03->interrupted) \
+			goto interrupt; \
+		goto *labels[rp2a03_fetch(rp2a03)]; \
+	} while (0)
 
-void STA_IX(struct rp2a03 *rp2a03)
+void rp2a03_tick(clock_data_t *data)
 {
-	uint8_t b = (memory_readb(rp2a03->bus_id, rp2a03->PC++) + rp2a03->X);
-	uint16_t address = memory_readb(rp2a03->bus_id, b % ZP_SIZE) |
-		(memory_readb(rp2a03->bus_id, (b + 1) % ZP_SIZE) << 8);
-	memory_writeb(rp2a03->bus_id, rp2a03->A, address);
-	clock_consume(6);
-}
+	static void *const labels[256] = { RP2A03_OPCODES(OPCODE_LABEL) };
+	struct rp2a03 *rp2a03 = data;
 
-void STA_IY(struct rp2a03 *rp2a03)
-{
-	uint16_t address = memory_readw(rp2a03->bus_id,
-		memory_readb(rp2a03->bus_id, rp2a03->PC++)) + rp2a03->Y;
-	memory_writeb(rp2a03->bus_id, rp2a03->A, address);
-	clock_consume(6);
-}
+	/* Handle pending interrupt or run first instruction */
+	if (rp2a03->interrupted)
+		goto interrupt;
+	goto *labels[rp2a03_fetch(rp2a03)];
 
-void STA_ZP(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->A, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	clock_consume(3);
-}
+	/* Opcode handlers */
+	RP2A03_OPCODES(OPCODE_BLOCK)
 
-void STA_ZPX(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->A, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	clock_consume(4);
+interrupt:
+	rp2a03_nmi(rp2a03);
+	DISPATCH();
 }
 
-void STX_A(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->X, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
+#endif
 
-void STX_ZP(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->X, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	clock_consume(3);
-}
+#if !defined(CONFIG_CPU_RP2A03_THREADED) || defined(CONFIG_CPU_RP2A03_JIT)
 
-void STX_ZPY(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->X, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->Y) % ZP_SIZE);
-	clock_consume(4);
-}
+/* Opcode handler table */
+#define OPCODE_HANDLER(opcode, handler, length) \
+	[opcode] = handler,
+static const rp2a03_handler_t rp2a03_handlers[256] = {
+	RP2A03_OPCODES(OPCODE_HANDLER)
+};
 
-void STY_A(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->Y, memory_readw(rp2a03->bus_id,
-		rp2a03->PC));
-	rp2a03->PC += 2;
-	clock_consume(4);
-}
+#endif
 
-void STY_ZP(struct rp2a03 *rp2a03)
-{
-	memory_writeb(rp2a03->bus_id, rp2a03->Y, memory_readb(rp2a03->bus_id,
-		rp2a03->PC++));
-	clock_consume(3);
-}
+#ifndef CONFIG_CPU_RP2A03_THREADED
 
-void STY_ZPX(struct rp2a03 *rp2a03)
+void rp2a03_step(struct rp2a03 *rp2a03)
 {
-	memory_writeb(rp2a03->bus_id, rp2a03->Y, (memory_readb(rp2a03->bus_id,
-		rp2a03->PC++) + rp2a03->X) % ZP_SIZE);
-	clock_consume(4);
-}
+	uint8_t opcode;
 
-void TAX(struct rp2a03 *rp2a03)
-{
-	rp2a03->X = rp2a03->A;
-	rp2a03->Z = (rp2a03->X == 0);
-	rp2a03->N = ((rp2a03->X & 0x80) != 0);
-	clock_consume(2);
-}
+	/* Check if CPU has been interrupted */
+	if (rp2a03->interrupted) {
+		rp2a03_nmi(rp2a03);
+		return;
+	}
 
-void TAY(struct rp2a03 *rp2a03)
-{
-	rp2a03->Y = rp2a03->A;
-	rp2a03->Z = (rp2a03->Y == 0);
-	rp2a03->N = ((rp2a03->Y & 0x80) != 0);
-	clock_consume(2);
+	/* Fetch and execute opcode */
+	opcode = rp2a03_fetch(rp2a03);
+	rp2a03_handlers[opcode](rp2a03);
 }
 
-void TSX(struct rp2a03 *rp2a03)
+void rp2a03_tick(clock_data_t *data)
 {
-	rp2a03->X = rp2a03->S;
-	rp2a03->Z = (rp2a03->X == 0);
-	rp2a03->N = ((rp2a03->X & 0x80) != 0);
-	clock_consume(2);
-}
+	struct rp2a03 *rp2a03 = data;
 
-void TXA(struct rp2a03 *rp2a03)
-{
-	rp2a03->A = rp2a03->X;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(2);
+	/* Execute instructions until another clock is due */
+	do {
+		rp2a03_step(rp2a03);
+	} while (clock_run_ahead());
 }
 
-void TXS(struct rp2a03 *rp2a03)
-{
-	rp2a03->S = rp2a03->X;
-	clock_consume(2);
-}
+#endif
 
-void TYA(struct rp2a03 *rp2a03)
-{
-	rp2a03->A = rp2a03->Y;
-	rp2a03->Z = (rp2a03->A == 0);
-	rp2a03->N = ((rp2a03->A & 0x80) != 0);
-	clock_consume(2);
-}
+#ifdef CONFIG_CPU_RP2A03_JIT
 
-void rp2a03_tick(clock_data_t *data)
+uint8_t rp2a03_jit_decode(struct bus *bus, uint16_t address, uint8_t *opcode,
+	uint16_t *operand)
 {
-	struct rp2a03 *rp2a03 = data;
-	uint8_t opcode;
-
-	/* Check if CPU has been interrupted */
-	if (rp2a03->interrupted) {
-		/* Save PC */
-		memory_writeb(rp2a03->bus_id, rp2a03->PC >> 8, STACK_START +
-			rp2a03->S--);
-		memory_writeb(rp2a03->bus_id, rp2a03->PC & 0xFF, STACK_START +
-			rp2a03->S--);
+	uint8_t *mem;
+	uint8_t length;
 
-		/* Push flags */
-		memory_writeb(rp2a03->bus_id, rp2a03->P, STACK_START +
-			rp2a03->S--);
+	/* Only instructions located in read-only memory can be translated */
+	if (!rp2a03_cacheable(bus, address))
+		return 0;
 
-		/* Interrupt is now active */
-		rp2a03->I = 1;
+	/* Peek at opcode (without affecting the data bus) */
+	mem = memory_bus_page(bus, address)->read_mem;
+	*opcode = mem[address & BUS_PAGE_MASK];
+	length = rp2a03_lengths[*opcode];
+	if (!rp2a03_cacheable(bus, address + length - 1))
+		return 0;
 
-		/* Set PC to value written at the interrupt vector address */
-		rp2a03->PC = memory_readw(rp2a03->bus_id, NMI_VECTOR);
-		clock_consume(7);
-
-		/* Interrupt is now being handled */
-		rp2a03->interrupted = false;
-		return;
+	/* Peek at operand bytes (which may lie in the next page) */
+	*operand = 0;
+	if (length > 1) {
+		mem = memory_bus_page(bus, (uint16_t)(address + 1))->read_mem;
+		*operand = mem[(address + 1) & BUS_PAGE_MASK];
+	}
+	if (length > 2) {
+		mem = memory_bus_page(bus, (uint16_t)(address + 2))->read_mem;
+		*operand |= mem[(address + 2) & BUS_PAGE_MASK] << 8;
 	}
 
-	/* Fetch opcode */
-	opcode = memory_readb(rp2a03->bus_id, rp2a03->PC++);
+	return length;
+}
 
-	/* Execute opcode */
+bool rp2a03_jit_ends_block(uint8_t opcode)
+{
+	/* Branches, jumps, calls, returns and BRK change PC */
 	switch (opcode) {
 	case 0x00:
-		BRK(rp2a03);
-		break;
-	case 0x01:
-		ORA_IX(rp2a03);
-		break;
-	case 0x04:
-		NOP_D(rp2a03);
-		break;
-	case 0x05:
-		ORA_ZP(rp2a03);
-		break;
-	case 0x06:
-		ASL_ZP(rp2a03);
-		break;
-	case 0x08:
-		PHP(rp2a03);
-		break;
-	case 0x09:
-		ORA_I(rp2a03);
-		break;
-	case 0x0A:
-		ASL_ACC(rp2a03);
-		break;
-	case 0x0C:
-		NOP_A(rp2a03);
-		break;
-	case 0x0D:
-		ORA_A(rp2a03);
-		break;
-	case 0x0E:
-		ASL_A(rp2a03);
-		break;
-	case 0x10:
-		BPL(rp2a03);
-		break;
-	case 0x11:
-		ORA_IY(rp2a03);
-		break;
-	case 0x15:
-		ORA_ZPX(rp2a03);
-		break;
-	case 0x16:
-		ASL_ZPX(rp2a03);
-		break;
-	case 0x18:
-		CLC(rp2a03);
-		break;
-	case 0x19:
-		ORA_AY(rp2a03);
-		break;
-	case 0x1D:
-		ORA_AX(rp2a03);
-		break;
-	case 0x1E:
-		ASL_AX(rp2a03);
-		break;
 	case 0x20:
-		JSR(rp2a03);
-		break;
-	case 0x21:
-		AND_IX(rp2a03);
-		break;
-	case 0x24:
-		BIT_ZP(rp2a03);
-		break;
-	case 0x25:
-		AND_ZP(rp2a03);
-		break;
-	case 0x26:
-		ROL_ZP(rp2a03);
-		break;
-	case 0x28:
-		PLP(rp2a03);
-		break;
-	case 0x29:
-		AND_I(rp2a03);
-		break;
-	case 0x2A:
-		ROL_ACC(rp2a03);
-		break;
-	case 0x2C:
-		BIT_A(rp2a03);
-		break;
-	case 0x2D:
-		AND_A(rp2a03);
-		break;
-	case 0x2E:
-		ROL_A(rp2a03);
-		break;
-	case 0x30:
-		BMI(rp2a03);
-		break;
-	case 0x31:
-		AND_IY(rp2a03);
-		break;
-	case 0x35:
-		AND_ZPX(rp2a03);
-		break;
-	case 0x36:
-		ROL_ZPX(rp2a03);
-		break;
-	case 0x38:
-		SEC(rp2a03);
-		break;
-	case 0x39:
-		AND_AY(rp2a03);
-		break;
-	case 0x3D:
-		AND_AX(rp2a03);
-		break;
-	case 0x3E:
-		ROL_AX(rp2a03);
-		break;
 	case 0x40:
-		RTI(rp2a03);
-		break;
-	case 0x41:
-		EOR_IX(rp2a03);
-		break;
-	case 0x44:
-		NOP_D(rp2a03);
-		break;
-	case 0x45:
-		EOR_ZP(rp2a03);
-		break;
-	case 0x46:
-		LSR_ZP(rp2a03);
-		break;
-	case 0x48:
-		PHA(rp2a03);
-		break;
-	case 0x49:
-		EOR_I(rp2a03);
-		break;
-	case 0x4A:
-		LSR_ACC(rp2a03);
-		break;
 	case 0x4C:
-		JMP_A(rp2a03);
-		break;
-	case 0x4D:
-		EOR_A(rp2a03);
-		break;
-	case 0x4E:
-		LSR_A(rp2a03);
-		break;
-	case 0x50:
-		BVC(rp2a03);
-		break;
-	case 0x51:
-		EOR_IY(rp2a03);
-		break;
-	case 0x55:
-		EOR_ZPX(rp2a03);
-		break;
-	case 0x56:
-		LSR_ZPX(rp2a03);
-		break;
-	case 0x59:
-		EOR_AY(rp2a03);
-		break;
-	case 0x5D:
-		EOR_AX(rp2a03);
-		break;
-	case 0x5E:
-		LSR_AX(rp2a03);
-		break;
 	case 0x60:
-		RTS(rp2a03);
-		break;
-	case 0x61:
-		ADC_IX(rp2a03);
-		break;
-	case 0x64:
-		NOP_D(rp2a03);
-		break;
-	case 0x65:
-		ADC_ZP(rp2a03);
-		break;
-	case 0x66:
-		ROR_ZP(rp2a03);
-		break;
-	case 0x68:
-		PLA(rp2a03);
-		break;
-	case 0x69:
-		ADC_I(rp2a03);
-		break;
-	case 0x6A:
-		ROR_ACC(rp2a03);
-		break;
 	case 0x6C:
-		JMP_I(rp2a03);
-		break;
-	case 0x6D:
-		ADC_A(rp2a03);
-		break;
-	case 0x6E:
-		ROR_A(rp2a03);
-		break;
-	case 0x70:
-		BVS(rp2a03);
-		break;
-	case 0x71:
-		ADC_IY(rp2a03);
-		break;
-	case 0x75:
-		ADC_ZPX(rp2a03);
-		break;
-	case 0x76:
-		ROR_ZPX(rp2a03);
-		break;
-	case 0x78:
-		SEI(rp2a03);
-		break;
-	case 0x79:
-		ADC_AY(rp2a03);
-		break;
-	case 0x7D:
-		ADC_AX(rp2a03);
-		break;
-	case 0x7E:
-		ROR_AX(rp2a03);
-		break;
-	case 0x81:
-		STA_IX(rp2a03);
-		break;
-	case 0x84:
-		STY_ZP(rp2a03);
-		break;
-	case 0x85:
-		STA_ZP(rp2a03);
-		break;
-	case 0x86:
-		STX_ZP(rp2a03);
-		break;
-	case 0x88:
-		DEY(rp2a03);
-		break;
-	case 0x8A:
-		TXA(rp2a03);
-		break;
-	case 0x8C:
-		STY_A(rp2a03);
-		break;
-	case 0x8D:
-		STA_A(rp2a03);
-		break;
-	case 0x8E:
-		STX_A(rp2a03);
-		break;
-	case 0x90:
-		BCC(rp2a03);
-		break;
-	case 0x91:
-		STA_IY(rp2a03);
-		break;
-	case 0x94:
-		STY_ZPX(rp2a03);
-		break;
-	case 0x95:
-		STA_ZPX(rp2a03);
-		break;
-	case 0x96:
-		STX_ZPY(rp2a03);
-		break;
-	case 0x98:
-		TYA(rp2a03);
-		break;
-	case 0x99:
-		STA_AY(rp2a03);
-		break;
-	case 0x9A:
-		TXS(rp2a03);
-		break;
-	case 0x9D:
-		STA_AX(rp2a03);
-		break;
-	case 0xA0:
-		LDY_I(rp2a03);
-		break;
-	case 0xA1:
-		LDA_IX(rp2a03);
-		break;
-	case 0xA2:
-		LDX_I(rp2a03);
-		break;
-	case 0xA4:
-		LDY_ZP(rp2a03);
-		break;
-	case 0xA5:
-		LDA_ZP(rp2a03);
-		break;
-	case 0xA6:
-		LDX_ZP(rp2a03);
-		break;
-	case 0xA8:
-		TAY(rp2a03);
-		break;
-	case 0xA9:
-		LDA_I(rp2a03);
-		break;
-	case 0xAC:
-		LDY_A(rp2a03);
-		break;
-	case 0xAD:
-		LDA_A(rp2a03);
-		break;
-	case 0xAE:
-		LDX_A(rp2a03);
-		break;
-	case 0xAA:
-		TAX(rp2a03);
-		break;
-	case 0xB0:
-		BCS(rp2a03);
-		break;
-	case 0xB1:
-		LDA_IY(rp2a03);
-		break;
-	case 0xB4:
-		LDY_ZPX(rp2a03);
-		break;
-	case 0xB5:
-		LDA_ZPX(rp2a03);
-		break;
-	case 0xB6:
-		LDX_ZPY(rp2a03);
-		break;
-	case 0xB8:
-		CLV(rp2a03);
-		break;
-	case 0xB9:
-		LDA_AY(rp2a03);
-		break;
-	case 0xBA:
-		TSX(rp2a03);
-		break;
-	case 0xBC:
-		LDY_AX(rp2a03);
-		break;
-	case 0xBD:
-		LDA_AX(rp2a03);
-		break;
-	case 0xBE:
-		LDX_AY(rp2a03);
-		break;
-	case 0xC0:
-		CPY_I(rp2a03);
-		break;
-	case 0xC1:
-		CMP_IX(rp2a03);
-		break;
-	case 0xC4:
-		CPY_ZP(rp2a03);
-		break;
-	case 0xC5:
-		CMP_ZP(rp2a03);
-		break;
-	case 0xC6:
-		DEC_ZP(rp2a03);
-		break;
-	case 0xC8:
-		INY(rp2a03);
-		break;
-	case 0xC9:
-		CMP_I(rp2a03);
-		break;
-	case 0xCA:
-		DEX(rp2a03);
-		break;
-	case 0xCC:
-		CPY_A(rp2a03);
-		break;
-	case 0xCD:
-		CMP_A(rp2a03);
-		break;
-	case 0xCE:
-		DEC_A(rp2a03);
-		break;
-	case 0xD0:
-		BNE(rp2a03);
-		break;
-	case 0xD1:
-		CMP_IY(rp2a03);
-		break;
-	case 0xD5:
-		CMP_ZPX(rp2a03);
-		break;
-	case 0xD6:
-		DEC_ZPX(rp2a03);
-		break;
-	case 0xD8:
-		CLD(rp2a03);
-		break;
-	case 0xD9:
-		CMP_AY(rp2a03);
-		break;
-	case 0xDD:
-		CMP_AX(rp2a03);
-		break;
-	case 0xDE:
-		DEC_AX(rp2a03);
-		break;
-	case 0xE0:
-		CPX_I(rp2a03);
-		break;
-	case 0xE1:
-		SBC_IX(rp2a03);
-		break;
-	case 0xE4:
-		CPX_ZP(rp2a03);
-		break;
-	case 0xE5:
-		SBC_ZP(rp2a03);
-		break;
-	case 0xE6:
-		INC_ZP(rp2a03);
-		break;
-	case 0xE8:
-		INX(rp2a03);
-		break;
-	case 0xE9:
-		SBC_I(rp2a03);
-		break;
-	case 0xEA:
-		NOP(rp2a03);
-		break;
-	case 0xEC:
-		CPX_A(rp2a03);
-		break;
-	case 0xED:
-		SBC_A(rp2a03);
-		break;
-	case 0xEE:
-		INC_A(rp2a03);
-		break;
-	case 0xF0:
-		BEQ(rp2a03);
-		break;
-	case 0xF1:
-		SBC_IY(rp2a03);
-		break;
-	case 0xF5:
-		SBC_ZPX(rp2a03);
-		break;
-	case 0xF6:
-		INC_ZPX(rp2a03);
-		break;
-	case 0xF8:
-		SED(rp2a03);
-		break;
-	case 0xF9:
-		SBC_AY(rp2a03);
-		break;
-	case 0xFD:
-		SBC_AX(rp2a03);
-		break;
-	case 0xFE:
-		INC_AX(rp2a03);
-		break;
+		return true;
 	default:
-		LOG_W("rp2a03: unknown opcode (%02x)!\n", opcode);
-		clock_consume(1);
-		break;
+		return ((opcode & 0x1F) == 0x10);
+	}
+}
+
+jit_block_t rp2a03_jit_translate(struct rp2a03 *rp2a03, bool retry)
+{
+	struct bus *bus = &busses[rp2a03->bus_id];
+	struct jit *jit = rp2a03->jit;
+	uint16_t address = rp2a03->PC;
+	uint16_t operand;
+	uint8_t opcode;
+	uint8_t length;
+	uint8_t open_bus;
+	jit_block_t block;
+	int i;
+
+	/* Leave already if first instruction cannot be translated */
+	if (!rp2a03_jit_decode(bus, address, &opcode, &operand))
+		return NULL;
+
+	/* Leave already if code buffer cannot be written */
+	if (!jit_begin(jit))
+		return NULL;
+
+	for (i = 0; i < MAX_BLOCK_INSTRUCTIONS; i++) {
+		/* Stop at first instruction that cannot be translated */
+		length = rp2a03_jit_decode(bus, address, &opcode, &operand);
+		if (!length)
+			break;
+
+		/* Get data bus value left by fetching instruction bytes */
+		if (length == 1)
+			open_bus = opcode;
+		else if (length == 2)
+			open_bus = operand;
+		else
+			open_bus = operand >> 8;
+
+		/* Leave block before instruction if another clock is due, if an
+		NMI is pending or if the page table changed, as remaining code
+		might not be mapped anymore (checked by caller for first one) */
+		if (i > 0) {
+			jit_exit_unless_below(jit,
+				offsetof(struct rp2a03, clock.next_cycle), 0,
+				offsetof(struct rp2a03, clock.deadline));
+			jit_exit_if_set(jit,
+				offsetof(struct rp2a03, interrupted));
+			jit_exit_if_changed(jit,
+				offsetof(struct rp2a03, jit_bus_generation),
+				offsetof(struct rp2a03, jit_generation));
+		}
+
+		/* Set decoded operand, data bus value and next PC, then run
+		handler */
+		address += length;
+		if (length > 1)
+			jit_store16(jit, offsetof(struct rp2a03, operand),
+				operand);
+		jit_store8_ptr(jit, offsetof(struct rp2a03, jit_open_bus),
+			open_bus);
+		jit_store16(jit, offsetof(struct rp2a03, PC), address);
+		jit_call(jit, rp2a03_handlers[opcode]);
+
+		/* Stop after instructions changing PC */
+		if (rp2a03_jit_ends_block(opcode))
+			break;
 	}
+
+	/* Flush all blocks and translate again (once) if code buffer is
+	full */
+	block = jit_end(jit);
+	if (!block && retry && !jit_failed(jit)) {
+		rp2a03_jit_flush(rp2a03);
+		block = rp2a03_jit_translate(rp2a03, false);
+	}
+
+	return block;
+}
+
+jit_block_t rp2a03_jit_get_block(struct rp2a03 *rp2a03)
+{
+	struct bus *bus = &busses[rp2a03->bus_id];
+	struct rp2a03_cache_page *cache_page;
+	jit_block_t block;
+
+	/* Use translated block unless page table changed since translating */
+	cache_page = rp2a03->cache[rp2a03->PC >> BUS_PAGE_BITS];
+	if (cache_page && (cache_page->generation == bus->generation)) {
+		block = cache_page->blocks[rp2a03->PC & BUS_PAGE_MASK];
+		if (block)
+			return block;
+	}
+
+	/* Translate block and stop translating if code buffer protection
+	could not be changed */
+	block = rp2a03_jit_translate(rp2a03, true);
+	if (jit_failed(rp2a03->jit)) {
+		LOG_E("rp2a03: JIT code buffer unusable, disabling JIT!\n");
+		rp2a03->jit_mode = JIT_OFF;
+		return NULL;
+	}
+
+	/* Save block */
+	if (block) {
+		cache_page = rp2a03_cache_get(rp2a03, rp2a03->PC);
+		cache_page->blocks[rp2a03->PC & BUS_PAGE_MASK] = block;
+	}
+
+	return block;
+}
+
+void rp2a03_jit_flush(struct rp2a03 *rp2a03)
+{
+	int i;
+
+	/* Discard code buffer and drop all block references */
+	jit_flush(rp2a03->jit);
+	for (i = 0; i < NUM_CACHE_PAGES; i++)
+		if (rp2a03->cache[i])
+			memset(rp2a03->cache[i]->blocks, 0,
+				sizeof(rp2a03->cache[i]->blocks));
+}
+
+void rp2a03_jit_tick(clock_data_t *data)
+{
+	struct rp2a03 *rp2a03 = data;
+	struct bus *bus = &busses[rp2a03->bus_id];
+	jit_block_t block;
+
+	/* Point blocks to bus state they check and update */
+	rp2a03->jit_bus_generation = &bus->generation;
+	rp2a03->jit_open_bus = &bus->open_bus;
+
+	/* Execute blocks until another clock is due (instructions which
+	cannot be translated are interpreted) */
+	do {
+		if (rp2a03->interrupted) {
+			rp2a03_nmi(rp2a03);
+			continue;
+		}
+
+		block = NULL;
+		if (rp2a03->jit_mode != JIT_OFF)
+			block = rp2a03_jit_get_block(rp2a03);
+
+		if (block) {
+			rp2a03->jit_generation = bus->generation;
+			block(rp2a03);
+		} else
+			rp2a03_handlers[rp2a03_fetch(rp2a03)](rp2a03);
+	} while (clock_run_ahead());
 }
 
+#endif
+
 bool rp2a03_init(struct cpu_instance *instance)
 {
 	struct rp2a03 *rp2a03;
@@ -2254,6 +1239,9 @@ bool rp2a03_init(struct cpu_instance *instance)
 	rp2a03->unused = 1;
 	rp2a03->interrupted = false;
 
+	/* Start with an empty decoded instruction cache */
+	memset(rp2a03->cache, 0, sizeof(rp2a03->cache));
+
 	/* Save NMI IRQ number */
 	res = resource_get("nmi",
 		RESOURCE_IRQ,
@@ -2269,6 +1257,19 @@ bool rp2a03_init(struct cpu_instance *instance)
 	rp2a03->clock.rate = res->data.clk;
 	rp2a03->clock.data = rp2a03;
 	rp2a03->clock.tick = rp2a03_tick;
+
+#ifdef CONFIG_CPU_RP2A03_JIT
+	/* Translate blocks if requested (JIT is set up per instance, machine
+	instance mode overriding option) */
+	rp2a03->jit = NULL;
+	rp2a03->jit_mode = jit_get_mode(instance->jit_mode ?
+		instance->jit_mode : jit_mode_name);
+	if (rp2a03->jit_mode != JIT_OFF)
+		rp2a03->jit = jit_create(JIT_BUFFER_SIZE);
+	if (rp2a03->jit)
+		rp2a03->clock.tick = rp2a03_jit_tick;
+#endif
+
 	clock_add(&rp2a03->clock);
 
 	return true;
@@ -2289,6 +1290,18 @@ void rp2a03_interrupt(struct cpu_instance *instance, int irq)
 void rp2a03_deinit(struct cpu_instance *instance)
 {
 	struct rp2a03 *rp2a03 = instance->priv_data;
+	int i;
+
+	/* Free decoded instruction cache */
+	for (i = 0; i < NUM_CACHE_PAGES; i++)
+		free(rp2a03->cache[i]);
+
+#ifdef CONFIG_CPU_RP2A03_JIT
+	/* Free translated blocks */
+	if (rp2a03->jit)
+		jit_destroy(rp2a03->jit);
+#endif
+
 	free(rp2a03);
 }
 
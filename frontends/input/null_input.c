@@ -0,0 +1,16 @@
+#include <stdbool.h>
+#include <input.h>
+#include <util.h>
+
+static bool null_init(video_window_t *window);
+
+bool null_init(video_window_t *UNUSED(window))
+{
+	/* No input events are ever reported */
+	return true;
+}
+
+INPUT_START(null)
+	.init = null_init
+INPUT_END
+
@@ -0,0 +1,17 @@
+#include <stdbool.h>
+#include <util.h>
+#include <video.h>
+
+static bool null_init(int width, int height, int scale);
+
+bool null_init(int UNUSED(width), int UNUSED(height), int UNUSED(scale))
+{
+	/* Nothing is displayed (useful for benchmarking) */
+	return true;
+}
+
+VIDEO_START(null)
+	.input = "null",
+	.init = null_init
+VIDEO_END
+
@@ -21,6 +21,8 @@
 
 typedef void audio_data_t;
 
+struct audio_context;
+
 enum audio_format {
 	AUDIO_FORMAT_U8,
 	AUDIO_FORMAT_S8,
@@ -45,6 +47,9 @@ struct audio_frontend {
 	void (*deinit)();
 };
 
+struct audio_context *audio_create_context();
+void audio_set_context(struct audio_context *context);
+void audio_destroy_context(struct audio_context *context);
 bool audio_init(struct audio_specs *specs);
 void audio_start();
 void audio_stop();
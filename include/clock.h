@@ -6,18 +6,35 @@
 
 typedef void clock_data_t;
 
+struct clock_context;
+
 struct clock {
 	uint64_t rate;
 	clock_data_t *data;
 	uint64_t div;
-	int num_remaining_cycles;
+	uint64_t frac;
+	uint64_t rem;
+	uint64_t start_cycle;
+	uint64_t num_cycles;
+	uint64_t next_cycle;
+	uint64_t deadline;
+	int index;
 	void (*tick)(clock_data_t *clock_data);
 };
 
+struct clock_context *clock_create_context();
+void clock_set_context(struct clock_context *context);
+void clock_destroy_context(struct clock_context *context);
 void clock_add(struct clock *clock);
 void clock_reset();
 void clock_tick_all(bool handle_delay);
+bool clock_run_ahead();
 void clock_consume(int num_cycles);
+void clock_wake(struct clock *clock);
+uint64_t clock_get_rate();
+void clock_report_speed(uint64_t num_cycles, double real_time);
+uint64_t clock_get_cycle();
+uint64_t clock_get_sync_cycle(struct clock *clock);
 void clock_remove_all();
 
 #endif
@@ -23,6 +23,7 @@ typedef void controller_mach_data_t;
 typedef void controller_priv_data_t;
 
 struct controller_instance;
+struct controller_context;
 
 struct controller {
 	char *name;
@@ -41,6 +42,9 @@ struct controller_instance {
 	struct controller *controller;
 };
 
+struct controller_context *controller_create_context();
+void controller_set_context(struct controller_context *context);
+void controller_destroy_context(struct controller_context *context);
 bool controller_add(struct controller_instance *instance);
 void controller_reset_all();
 void controller_remove_all();
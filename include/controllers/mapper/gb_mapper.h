@@ -11,6 +11,8 @@
 struct gb_mapper_mach_data {
 	char *bootrom_path;
 	char *cart_path;
+	uint8_t *cart;		/* Filled by GB mapper */
+	int cart_size;		/* Filled by GB mapper */
 };
 
 struct cart_header {
@@ -15,6 +15,8 @@
 struct nes_mapper_mach_data {
 	char *path;
 	uint8_t *vram;
+	uint8_t *cart;		/* Filled by NES mapper */
+	int cart_size;		/* Filled by NES mapper */
 };
 
 struct cart_header {
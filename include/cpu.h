@@ -22,6 +22,7 @@ typedef void cpu_mach_data_t;
 typedef void cpu_priv_data_t;
 
 struct cpu_instance;
+struct cpu_context;
 
 struct cpu {
 	char *name;
@@ -38,9 +39,13 @@ struct cpu_instance {
 	int num_resources;
 	cpu_mach_data_t *mach_data;
 	cpu_priv_data_t *priv_data;
+	char *jit_mode;
 	struct cpu *cpu;
 };
 
+struct cpu_context *cpu_create_context(char *jit_mode);
+void cpu_set_context(struct cpu_context *context);
+void cpu_destroy_context(struct cpu_context *context);
 bool cpu_add(struct cpu_instance *instance);
 void cpu_reset_all();
 void cpu_interrupt(int irq);
@@ -1,6 +1,7 @@
 #ifndef _ENV_H
 #define _ENV_H
 
+void env_set_data_path(char *path);
 char *env_get_data_path();
 char *env_get_system_path();
 char *env_get_config_path();
@@ -21,6 +21,8 @@
 
 typedef void input_data_t;
 
+struct input_context;
+
 enum input_event_type {
 	EVENT_KEYBOARD,
 	EVENT_QUIT
@@ -53,6 +55,9 @@ struct input_frontend {
 	void (*deinit)();
 };
 
+struct input_context *input_create_context();
+void input_set_context(struct input_context *context);
+void input_destroy_context(struct input_context *context);
 bool input_init(char *name);
 bool input_load(char *name, struct input_event *events, int num_events);
 void input_update();
@@ -0,0 +1,42 @@
+#ifndef _JIT_H
+#define _JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Translated block (called with the data it was generated for, which
+generated code accesses by offset) */
+typedef void (*jit_block_t)(void *data);
+
+/* Functions called by blocks with block data */
+typedef void (*jit_func_t)();
+
+enum jit_mode {
+	JIT_OFF,
+	JIT_ON
+};
+
+struct jit;
+
+enum jit_mode jit_get_mode(char *name);
+
+struct jit *jit_create(size_t size);
+void jit_destroy(struct jit *jit);
+void jit_flush(struct jit *jit);
+bool jit_failed(struct jit *jit);
+bool jit_begin(struct jit *jit);
+jit_block_t jit_end(struct jit *jit);
+void jit_store8(struct jit *jit, int offset, uint8_t b);
+void jit_store16(struct jit *jit, int offset, uint16_t w);
+void jit_store8_ptr(struct jit *jit, int offset, uint8_t b);
+void jit_call(struct jit *jit, jit_func_t func);
+void jit_exit_unless_below(struct jit *jit, int offset, int32_t margin,
+	int limit_offset);
+void jit_exit_if_set(struct jit *jit, int offset);
+void jit_exit_if_masked(struct jit *jit, int flag_offset, int bits_offset,
+	int mask_offset);
+void jit_exit_if_changed(struct jit *jit, int ptr_offset, int value_offset);
+
+#endif
+
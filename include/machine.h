@@ -21,20 +21,40 @@
 
 typedef void machine_priv_data_t;
 
+struct clock_context;
+struct memory_context;
+struct cpu_context;
+struct controller_context;
+struct video_context;
+struct input_context;
+struct audio_context;
+
 struct machine {
 	char *name;
 	char *description;
+	char *data_path;
 	machine_priv_data_t *priv_data;
 	bool running;
+	struct clock_context *clock_context;
+	struct memory_context *memory_context;
+	struct cpu_context *cpu_context;
+	struct controller_context *controller_context;
+	struct video_context *video_context;
+	struct input_context *input_context;
+	struct audio_context *audio_context;
 	bool (*init)(struct machine *machine);
 	void (*reset)(struct machine *machine);
 	void (*deinit)(struct machine *machine);
 };
 
+struct machine *machine_create(char *name, char *data_path, char *jit_mode);
+void machine_select(struct machine *m);
+void machine_destroy(struct machine *m);
 bool machine_init();
 void machine_reset();
 void machine_run();
 void machine_step();
+bool machine_run_frame();
 void machine_deinit();
 
 extern struct list_link *machines;
@@ -1,15 +1,42 @@
 #ifndef _MEMORY_H
 #define _MEMORY_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <config.h>
 #include <resource.h>
 
 #define KB(x) (x * 1024)
 
-/* address_t size should match the maximum bus size of all supported machines */
+/* Busses are split into 256-byte pages for region lookup */
+#define BUS_PAGE_BITS	8
+#define BUS_PAGE_SIZE	(1 << BUS_PAGE_BITS)
+#define BUS_PAGE_MASK	(BUS_PAGE_SIZE - 1)
+
+/* Pages are grouped in tables of 256 pages (covering 64KB each) */
+#define BUS_TABLE_BITS	8
+#define BUS_TABLE_SIZE	(1 << BUS_TABLE_BITS)
+#define BUS_TABLE_MASK	(BUS_TABLE_SIZE - 1)
+
+/* address_t size should match the maximum bus size of all supported machines
+(wider busses use a two-level page table, 16-bit ones only need one table) */
+#ifdef CONFIG_MACH_WIDE_BUS
+#define ADDRESS_BITS	32
+typedef uint32_t address_t;
+#else
+#define ADDRESS_BITS	16
 typedef uint16_t address_t;
+#endif
 typedef void region_data_t;
 
+/* Watch flags (also used as access types by watch hooks) */
+#define WATCH_READ	(1 << 0)
+#define WATCH_WRITE	(1 << 1)
+#define WATCH_EXEC	(1 << 2)
+
+typedef void (*watch_hook_t)(int bus_id, address_t address, uint16_t value,
+	uint8_t type);
+
 struct mops {
 	uint8_t (*readb)(region_data_t *data, address_t address);
 	uint16_t (*readw)(region_data_t *data, address_t address);
@@ -17,20 +44,180 @@ struct mops {
 	void (*writew)(region_data_t *data, uint16_t w, address_t address);
 };
 
+struct region;
+struct watch;
+struct memory_context;
+
+struct trace_entry {
+	uint64_t cycle;
+	int bus_id;
+	address_t address;
+	uint16_t value;
+	uint8_t type;
+};
+
+struct page {
+	struct region *region;
+	uint8_t *read_mem;
+	uint8_t *write_mem;
+	unsigned long num_unmapped_accesses;
+	uint8_t watch;
+};
+
+struct bus {
+	int width;
+	address_t mask;
+	struct region *regions;
+	int num_regions;
+	int max_regions;
+	struct page **tables;
+	int num_tables;
+	struct page *pages;
+	bool dirty;
+	unsigned int generation;
+	uint8_t open_bus;
+	struct watch *watches;
+	int num_watches;
+};
+
+struct memory_context *memory_create_context();
+void memory_set_context(struct memory_context *context);
+void memory_destroy_context(struct memory_context *context);
 void memory_bus_add(int width);
 void memory_bus_remove_all();
 void memory_region_add(struct resource *area, struct mops *mops,
 	region_data_t *data);
 void memory_region_remove(struct resource *area);
-uint8_t memory_readb(int bus_id, address_t address);
-uint16_t memory_readw(int bus_id, address_t address);
-void memory_writeb(int bus_id, uint8_t b, address_t address);
-void memory_writew(int bus_id, uint16_t w, address_t address);
+void memory_region_swap(struct resource *area, struct mops *mops,
+	region_data_t *data);
+void memory_region_rebind(struct resource *area, region_data_t *data);
+uint8_t memory_region_readb(int bus_id, address_t address);
+uint8_t memory_region_fetchb(int bus_id, address_t address);
+uint16_t memory_region_readw(int bus_id, address_t address);
+void memory_region_writeb(int bus_id, uint8_t b, address_t address);
+void memory_region_writew(int bus_id, uint16_t w, address_t address);
+void memory_read_block(int bus_id, address_t address, uint8_t *buf, int size);
+void memory_write_block(int bus_id, address_t address, uint8_t *buf, int size);
+void memory_write_port(int bus_id, address_t address, uint8_t *buf, int size);
+void memory_copy_block(int dest_bus_id, address_t dest, int src_bus_id,
+	address_t src, int size);
+void memory_watch_add(int bus_id, address_t start, address_t end,
+	uint8_t flags);
+void memory_watch_remove(int bus_id, address_t start, address_t end);
+void memory_watch_set_hook(watch_hook_t hook);
 void *memory_map_file(char *path, int offset, int size);
+void *memory_map_image(char *path, int *size);
 void memory_unmap_file(void *data, int size);
 
+static inline struct page *memory_bus_page(struct bus *bus,
+	address_t address);
+static inline uint8_t memory_readb(int bus_id, address_t address);
+static inline uint8_t memory_fetchb(int bus_id, address_t address);
+static inline uint16_t memory_readw(int bus_id, address_t address);
+static inline void memory_writeb(int bus_id, uint8_t b, address_t address);
+static inline void memory_writew(int bus_id, uint16_t w, address_t address);
+
+extern __thread struct bus *busses;
 extern struct mops rom_mops;
 extern struct mops ram_mops;
 
+/* Plain memory pages are accessed directly, other accesses (MMIO regions,
+shared, unmapped or watched pages) are handled by the out-of-line region
+functions; every access latches the last data bus value (returned by open
+bus reads) */
+
+struct page *memory_bus_page(struct bus *bus, address_t address)
+{
+#ifdef CONFIG_MACH_WIDE_BUS
+	/* Unused tables point to a shared empty table (no check is needed) */
+	return &bus->tables[address >> (BUS_PAGE_BITS + BUS_TABLE_BITS)]
+		[(address >> BUS_PAGE_BITS) & BUS_TABLE_MASK];
+#else
+	/* 16-bit busses fit in their first table */
+	return &bus->pages[address >> BUS_PAGE_BITS];
+#endif
+}
+
+uint8_t memory_readb(int bus_id, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+
+	address &= bus->mask;
+	page = memory_bus_page(bus, address);
+	if (page->read_mem)
+		return bus->open_bus = page->read_mem[address & BUS_PAGE_MASK];
+
+	return memory_region_readb(bus_id, address);
+}
+
+uint8_t memory_fetchb(int bus_id, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+
+	/* Opcode fetches only differ from reads for watched pages */
+	address &= bus->mask;
+	page = memory_bus_page(bus, address);
+	if (page->read_mem)
+		return bus->open_bus = page->read_mem[address & BUS_PAGE_MASK];
+
+	return memory_region_fetchb(bus_id, address);
+}
+
+uint16_t memory_readw(int bus_id, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+	uint8_t *mem;
+
+	/* Words crossing a page boundary are handled by the region */
+	address &= bus->mask;
+	page = memory_bus_page(bus, address);
+	if (page->read_mem && ((address & BUS_PAGE_MASK) != BUS_PAGE_MASK)) {
+		mem = page->read_mem + (address & BUS_PAGE_MASK);
+		bus->open_bus = *(mem + 1);
+		return (*(mem + 1) << 8) | *mem;
+	}
+
+	return memory_region_readw(bus_id, address);
+}
+
+void memory_writeb(int bus_id, uint8_t b, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+
+	address &= bus->mask;
+	page = memory_bus_page(bus, address);
+	if (page->write_mem) {
+		page->write_mem[address & BUS_PAGE_MASK] = b;
+		bus->open_bus = b;
+		return;
+	}
+
+	memory_region_writeb(bus_id, b, address);
+}
+
+void memory_writew(int bus_id, uint16_t w, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+	uint8_t *mem;
+
+	/* Words crossing a page boundary are handled by the region */
+	address &= bus->mask;
+	page = memory_bus_page(bus, address);
+	if (page->write_mem && ((address & BUS_PAGE_MASK) != BUS_PAGE_MASK)) {
+		mem = page->write_mem + (address & BUS_PAGE_MASK);
+		*mem++ = w;
+		*mem = w >> 8;
+		bus->open_bus = w >> 8;
+		return;
+	}
+
+	memory_region_writew(bus_id, w, address);
+}
+
 #endif
 
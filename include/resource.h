@@ -43,8 +43,8 @@ struct resource {
 	union {
 		struct {
 			int bus_id;
-			uint16_t start;
-			uint16_t end;
+			uint32_t start;
+			uint32_t end;
 		} mem;
 		int irq;
 		uint64_t clk;
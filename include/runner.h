@@ -0,0 +1,20 @@
+#ifndef _RUNNER_H
+#define _RUNNER_H
+
+#include <stdbool.h>
+
+struct runner_job {
+	char *machine_name;
+	char *data_path;
+	char *jit_mode;
+	unsigned long num_frames;
+	unsigned long num_frames_run;
+	bool failed;
+};
+
+bool runner_run(struct runner_job *jobs, int num_jobs, int num_workers);
+bool runner_requested();
+bool runner_run_all();
+
+#endif
+
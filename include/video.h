@@ -21,6 +21,8 @@
 
 typedef void video_window_t;
 
+struct video_context;
+
 struct color {
 	uint8_t r;
 	uint8_t g;
@@ -40,9 +42,13 @@ struct video_frontend {
 	void (*deinit)();
 };
 
+struct video_context *video_create_context();
+void video_set_context(struct video_context *context);
+void video_destroy_context(struct video_context *context);
 bool video_init(int width, int height);
 video_window_t *video_get_window();
 void video_update();
+unsigned long video_get_num_frames();
 void video_lock();
 void video_unlock();
 struct color video_get_pixel(int x, int y);
@@ -56,8 +56,9 @@ bool chip8_init(struct machine *machine)
 	unsigned int size;
 	unsigned int max_rom_size;
 
-	/* Create machine data structure */
+	/* Create machine data structure (freed by deinit on failure) */
 	chip8_data = malloc(sizeof(struct chip8_data));
+	machine->priv_data = chip8_data;
 
 	/* Open ROM file */
 	rom_path = env_get_data_path();
@@ -87,20 +88,14 @@ bool chip8_init(struct machine *machine)
 
 	/* Copy ROM contents to RAM (starting at ROM address) */
 	if (fread(&chip8_data->ram[ROM_ADDRESS], 1, size, f) != size) {
-		free(chip8_data);
 		fclose(f);
 		LOG_E("Could not read ROM from \"%s\"!\n", rom_path);
 		return false;
 	}
 	fclose(f);
 
-	if (!cpu_add(&chip8_cpu_instance)) {
-		free(chip8_data);
+	if (!cpu_add(&chip8_cpu_instance))
 		return false;
-	}
-
-	/* Save machine data structure */
-	machine->priv_data = chip8_data;
 
 	return true;
 }
@@ -56,6 +56,7 @@ struct gb_data {
 	uint8_t wram[WRAM_SIZE];
 	uint8_t oam[OAM_SIZE];
 	uint8_t hram[HRAM_SIZE];
+	struct gb_mapper_mach_data gb_mapper_mach_data;
 };
 
 static bool gb_init();
@@ -86,8 +87,6 @@ static struct cpu_instance cpu_instance = {
 };
 
 /* GB mapper controller */
-static struct gb_mapper_mach_data gb_mapper_mach_data;
-
 static struct resource gb_mapper_resources[] = {
 	MEM("bootrom", BUS_ID, BOOTROM_START, BOOTROM_END),
 	MEM("rom0", BUS_ID, ROM0_START, ROM0_END),
@@ -99,8 +98,7 @@ static struct controller_instance gb_mapper_instance = {
 	.controller_name = "gb_mapper",
 	.bus_id = BUS_ID,
 	.resources = gb_mapper_resources,
-	.num_resources = ARRAY_SIZE(gb_mapper_resources),
-	.mach_data = &gb_mapper_mach_data
+	.num_resources = ARRAY_SIZE(gb_mapper_resources)
 };
 
 /* LCD controller */
@@ -121,13 +119,15 @@ static struct controller_instance lcdc_instance = {
 bool gb_init(struct machine *machine)
 {
 	struct gb_data *gb_data;
+	struct gb_mapper_mach_data *mapper_mach_data;
+	struct controller_instance mapper_instance = gb_mapper_instance;
 
-	/* Create machine data structure */
+	/* Create machine data structure (freed by deinit on failure) */
 	gb_data = malloc(sizeof(struct gb_data));
+	machine->priv_data = gb_data;
 
 	/* Validate bootrom option */
 	if (!bootrom_path) {
-		free(gb_data);
 		LOG_E("Please provide a bootrom option!\n");
 		return false;
 	}
@@ -141,20 +141,17 @@ bool gb_init(struct machine *machine)
 	memory_region_add(&hram_area, &ram_mops, gb_data->hram);
 	memory_region_add(&oam_area, &ram_mops, gb_data->oam);
 
-	/* Set GB mapper controller machine data */
-	gb_mapper_mach_data.bootrom_path = bootrom_path;
-	gb_mapper_mach_data.cart_path = env_get_data_path();
+	/* Set GB mapper controller machine data (kept per machine instance) */
+	mapper_mach_data = &gb_data->gb_mapper_mach_data;
+	mapper_mach_data->bootrom_path = bootrom_path;
+	mapper_mach_data->cart_path = env_get_data_path();
+	mapper_instance.mach_data = mapper_mach_data;
 
 	/* Add controllers and CPU */
-	if (!controller_add(&gb_mapper_instance) ||
+	if (!controller_add(&mapper_instance) ||
 		!controller_add(&lcdc_instance) ||
-		!cpu_add(&cpu_instance)) {
-		free(gb_data);
+		!cpu_add(&cpu_instance))
 		return false;
-	}
-
-	/* Save machine data structure */
-	machine->priv_data = gb_data;
 
 	return true;
 }
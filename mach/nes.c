@@ -63,6 +63,7 @@ struct nes_data {
 	uint8_t wram[WRAM_SIZE];
 	uint8_t vram[VRAM_SIZE];
 	uint8_t palette[PALETTE_SIZE];
+	struct nes_mapper_mach_data nes_mapper_mach_data;
 };
 
 static bool nes_init();
@@ -124,8 +125,6 @@ static struct controller_instance nes_controller_instance = {
 };
 
 /* NES mapper controller */
-static struct nes_mapper_mach_data nes_mapper_mach_data;
-
 static struct resource vram_mirror =
 	MEM("vram", PPU_BUS_ID, VRAM_MIRROR_START, VRAM_MIRROR_END);
 
@@ -140,8 +139,7 @@ static struct resource nes_mapper_resources[] = {
 static struct controller_instance nes_mapper_instance = {
 	.controller_name = "nes_mapper",
 	.resources = nes_mapper_resources,
-	.num_resources = ARRAY_SIZE(nes_mapper_resources),
-	.mach_data = &nes_mapper_mach_data
+	.num_resources = ARRAY_SIZE(nes_mapper_resources)
 };
 
 /* PPU controller */
@@ -206,12 +204,17 @@ void palette_writeb(region_data_t *data, uint8_t b, address_t address)
 bool nes_init(struct machine *machine)
 {
 	struct nes_data *nes_data;
+	struct nes_mapper_mach_data *mapper_mach_data;
+	struct controller_instance mapper_instance = nes_mapper_instance;
 
-	/* Create machine data structure */
+	/* Create machine data structure (freed by deinit on failure) */
 	nes_data = malloc(sizeof(struct nes_data));
+	machine->priv_data = nes_data;
 
-	/* Set mapper path */
-	nes_mapper_mach_data.path = env_get_data_path();
+	/* Set mapper path (mapper data is kept per machine instance) */
+	mapper_mach_data = &nes_data->nes_mapper_mach_data;
+	mapper_mach_data->path = env_get_data_path();
+	mapper_instance.mach_data = mapper_mach_data;
 
 	/* Add memory busses */
 	memory_bus_add(16); /* CPU bus */
@@ -222,20 +225,15 @@ bool nes_init(struct machine *machine)
 	memory_region_add(&palette_area, &palette_mops, nes_data->palette);
 
 	/* NES cart controls VRAM address lines so let the mapper handle it */
-	nes_mapper_mach_data.vram = nes_data->vram;
+	mapper_mach_data->vram = nes_data->vram;
 
 	/* Add controllers and CPU */
 	if (!controller_add(&sprite_dma_instance) ||
-		!controller_add(&nes_mapper_instance) ||
+		!controller_add(&mapper_instance) ||
 		!controller_add(&ppu_instance) ||
 		!controller_add(&nes_controller_instance) ||
-		!cpu_add(&rp2a03_instance)) {
-		free(nes_data);
+		!cpu_add(&rp2a03_instance))
 		return false;
-	}
-
-	/* Save machine data structure */
-	machine->priv_data = nes_data;
 
 	return true;
 }
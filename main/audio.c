@@ -1,23 +1,44 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <audio.h>
 #include <cmdline.h>
 #include <list.h>
 #include <log.h>
 
+struct audio_context {
+	struct audio_frontend *frontend;
+};
+
 /* Command-line parameter */
 static char *audio_fe_name;
 PARAM(audio_fe_name, string, "audio", NULL, "Selects audio frontend")
 
 struct list_link *audio_frontends;
-static struct audio_frontend *frontend;
+static __thread struct audio_context *ctx;
+
+struct audio_context *audio_create_context()
+{
+	/* Allocate empty context (no frontend) */
+	return calloc(1, sizeof(struct audio_context));
+}
+
+void audio_set_context(struct audio_context *context)
+{
+	ctx = context;
+}
+
+void audio_destroy_context(struct audio_context *context)
+{
+	free(context);
+}
 
 bool audio_init(struct audio_specs *specs)
 {
 	struct list_link *link = audio_frontends;
 	struct audio_frontend *fe;
 
-	if (frontend) {
+	if (ctx->frontend) {
 		LOG_E("Audio frontend already initialized!\n");
 		return false;
 	}
@@ -32,7 +53,7 @@ bool audio_init(struct audio_specs *specs)
 	while ((fe = list_get_next(&link)))
 		if (!strcmp(audio_fe_name, fe->name)) {
 			if ((fe->init && fe->init(specs))) {
-				frontend = fe;
+				ctx->frontend = fe;
 				return true;
 			}
 			return false;
@@ -45,20 +66,20 @@ bool audio_init(struct audio_specs *specs)
 
 void audio_start()
 {
-	if (frontend->start)
-		frontend->start();
+	if (ctx->frontend->start)
+		ctx->frontend->start();
 }
 
 void audio_stop()
 {
-	if (frontend->stop)
-		frontend->stop();
+	if (ctx->frontend->stop)
+		ctx->frontend->stop();
 }
 
 void audio_deinit()
 {
-	if (frontend->deinit)
-		frontend->deinit();
-	frontend = NULL;
+	if (ctx->frontend->deinit)
+		ctx->frontend->deinit();
+	ctx->frontend = NULL;
 }
 
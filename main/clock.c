@@ -1,151 +1,605 @@
+#include <errno.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <unistd.h>
-#include <sys/time.h>
+#include <string.h>
+#include <time.h>
 #include <clock.h>
+#include <config.h>
 #include <log.h>
+#include <util.h>
 
 #define NS(s) ((s) * 1000000000)
+#define PACING_RATE	60
+#define MAX_LAG		(NS(1) / 10)
 
-static uint64_t gcd(uint64_t a, uint64_t b);
-static uint64_t lcm(uint64_t a, uint64_t b);
-static uint64_t lcmm(int clock_index);
-
-static struct clock **clocks;
-static int num_clocks;
-static uint64_t machine_clock_rate;
-static uint64_t current_cycle;
-static unsigned int mach_delay;
-static struct timeval start_time;
-static struct clock *current_clock;
-
-uint64_t gcd(uint64_t a, uint64_t b)
-{
-	uint64_t t;
-	while (b) {
-		t = b;
-		b = a % b;
-		a = t;
+#ifdef CONFIG_CLOCK_PROFILING
+/* Step sizes are counted in power-of-two buckets */
+#define NUM_STEP_BUCKETS	64
+
+struct clock_profile {
+	uint64_t num_ticks;
+	uint64_t num_cycles;
+	uint64_t num_wakes;
+	uint64_t time;
+};
+#endif
+
+struct clock_context {
+	struct clock **clocks;
+	int num_clocks;
+	struct clock **queue;
+	int num_queued;
+	struct clock **due_clocks;
+	int num_due_clocks;
+	int due_index;
+	uint64_t machine_clock_rate;
+	uint64_t current_cycle;
+	uint64_t num_elapsed_cycles;
+	uint64_t next_pacing_cycle;
+	struct timespec start_time;
+	struct clock *current_clock;
+#ifdef CONFIG_CLOCK_PROFILING
+	struct clock_profile *profiles;
+	uint64_t step_histogram[NUM_STEP_BUCKETS];
+	uint64_t num_steps;
+	uint64_t total_time;
+	sig_atomic_t num_dumps;
+#endif
+};
+
+static uint64_t clock_get_machine_cycle(struct clock *clock,
+	uint64_t num_cycles);
+static uint64_t clock_get_num_cycles(struct clock *clock, uint64_t cycle);
+static void clock_set_num_cycles(struct clock *clock, uint64_t num_cycles);
+static bool clock_before(struct clock *a, struct clock *b);
+static void clock_sift_up(int index);
+static void clock_sift_down(int index);
+static void clock_push(struct clock *clock);
+static struct clock *clock_pop();
+static void clock_set_deadline();
+static void clock_pace();
+#ifdef CONFIG_CLOCK_PROFILING
+static uint64_t clock_profile_get_time();
+static void clock_profile_tick(struct clock *clock);
+static void clock_profile_step(uint64_t num_cycles, uint64_t start_time);
+static void clock_profile_dump();
+static void clock_profile_signal(int signum);
+static void clock_profile_init();
+#endif
+
+static __thread struct clock_context *ctx;
+#ifdef CONFIG_CLOCK_PROFILING
+static volatile sig_atomic_t num_dump_requests;
+#endif
+
+uint64_t clock_get_machine_cycle(struct clock *clock, uint64_t num_cycles)
+{
+	uint64_t rate = ctx->machine_clock_rate;
+	uint64_t q = num_cycles / clock->rate;
+	uint64_t r = num_cycles % clock->rate;
+
+	/* Compute machine cycle at which clock cycle occurs (rounding down and
+	splitting computation to avoid overflows) */
+	return clock->start_cycle + q * rate + r * rate / clock->rate;
+}
+
+uint64_t clock_get_num_cycles(struct clock *clock, uint64_t cycle)
+{
+	uint64_t rate = ctx->machine_clock_rate;
+	uint64_t q = (cycle - clock->start_cycle) / rate;
+	uint64_t r = (cycle - clock->start_cycle) % rate;
+
+	/* Count clock cycles occurring before machine cycle */
+	return q * clock->rate + (r * clock->rate + rate - 1) / rate;
+}
+
+void clock_set_num_cycles(struct clock *clock, uint64_t num_cycles)
+{
+	/* Set clock cycle count along with matching event and fraction */
+	clock->num_cycles = num_cycles;
+	clock->next_cycle = clock_get_machine_cycle(clock, num_cycles);
+	clock->rem = (num_cycles % clock->rate) * clock->frac % clock->rate;
+}
+
+bool clock_before(struct clock *a, struct clock *b)
+{
+	/* Clocks due at the same cycle are ticked in registration order */
+	if (a->next_cycle != b->next_cycle)
+		return a->next_cycle < b->next_cycle;
+	return a->index < b->index;
+}
+
+void clock_sift_up(int index)
+{
+	struct clock **queue = ctx->queue;
+	struct clock *clock = queue[index];
+	int parent;
+
+	/* Move clock up until its parent is due before it */
+	while (index > 0) {
+		parent = (index - 1) / 2;
+		if (!clock_before(clock, queue[parent]))
+			break;
+		queue[index] = queue[parent];
+		index = parent;
+	}
+	queue[index] = clock;
+}
+
+void clock_sift_down(int index)
+{
+	struct clock **queue = ctx->queue;
+	struct clock *clock = queue[index];
+	int num_queued = ctx->num_queued;
+	int child;
+
+	/* Move clock down until its children are due after it */
+	while ((child = 2 * index + 1) < num_queued) {
+		if ((child + 1 < num_queued) &&
+			clock_before(queue[child + 1], queue[child]))
+			child++;
+		if (!clock_before(queue[child], clock))
+			break;
+		queue[index] = queue[child];
+		index = child;
+	}
+	queue[index] = clock;
+}
+
+void clock_push(struct clock *clock)
+{
+	ctx->queue[ctx->num_queued++] = clock;
+	clock_sift_up(ctx->num_queued - 1);
+}
+
+struct clock *clock_pop()
+{
+	struct clock *clock = ctx->queue[0];
+
+	/* Replace earliest clock with last one and restore heap order */
+	if (--ctx->num_queued > 0) {
+		ctx->queue[0] = ctx->queue[ctx->num_queued];
+		clock_sift_down(0);
+	}
+	return clock;
+}
+
+void clock_set_deadline()
+{
+	struct clock *clock = ctx->current_clock;
+
+	/* Other clocks still need to be ticked at current cycle */
+	if (ctx->due_index + 1 < ctx->num_due_clocks) {
+		clock->deadline = 0;
+		return;
+	}
+
+	/* Current clock can run until next queued event (other clocks cannot
+	change state before it, so running ahead does not affect results) */
+	clock->deadline = (ctx->num_queued > 0) ?
+		ctx->queue[0]->next_cycle : UINT64_MAX;
+}
+
+void clock_pace()
+{
+	uint64_t rate = ctx->machine_clock_rate;
+	struct timespec deadline;
+	struct timespec now;
+	int64_t lag;
+
+	/* Compute absolute deadline of current cycle (no drift accumulates as
+	deadlines are always derived from start time) */
+	deadline.tv_sec = ctx->start_time.tv_sec + ctx->current_cycle / rate;
+	deadline.tv_nsec = ctx->start_time.tv_nsec +
+		(ctx->current_cycle % rate) * NS(1) / rate;
+	if (deadline.tv_nsec >= NS(1)) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= NS(1);
+	}
+
+	/* Compute lag behind deadline (in ns) */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	lag = NS((int64_t)(now.tv_sec - deadline.tv_sec)) +
+		(now.tv_nsec - deadline.tv_nsec);
+
+	/* Sleep until deadline if ahead, or restart pacing from now if too far
+	behind (rather than running flat out to catch up) */
+	if (lag < 0) {
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+			&deadline, NULL) == EINTR);
+	} else if (lag > MAX_LAG) {
+		ctx->start_time = now;
+		ctx->current_cycle = 0;
+	}
+
+	/* Schedule next pacing point */
+	ctx->next_pacing_cycle = ctx->current_cycle + rate / PACING_RATE;
+}
+
+#ifdef CONFIG_CLOCK_PROFILING
+uint64_t clock_profile_get_time()
+{
+	struct timespec now;
+
+	/* Get monotonic time in nanoseconds */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return NS((uint64_t)now.tv_sec) + now.tv_nsec;
+}
+
+void clock_profile_tick(struct clock *clock)
+{
+	struct clock_profile *profile = &ctx->profiles[clock->index];
+	uint64_t num_cycles = clock->num_cycles;
+	uint64_t start_time;
+
+	/* Tick clock and account for its callback time and cycles */
+	start_time = clock_profile_get_time();
+	clock->tick(clock->data);
+	profile->time += clock_profile_get_time() - start_time;
+	profile->num_cycles += clock->num_cycles - num_cycles;
+	profile->num_ticks++;
+}
+
+void clock_profile_step(uint64_t num_cycles, uint64_t start_time)
+{
+	int bucket = 0;
+
+	/* Count step size in bucket matching its highest bit set */
+	while ((bucket < NUM_STEP_BUCKETS - 1) && (num_cycles >> (bucket + 1)))
+		bucket++;
+	ctx->step_histogram[bucket]++;
+	ctx->num_steps++;
+	ctx->total_time += clock_profile_get_time() - start_time;
+
+	/* Dump profile if requested through signal */
+	if (ctx->num_dumps != num_dump_requests) {
+		ctx->num_dumps = num_dump_requests;
+		clock_profile_dump();
+	}
+}
+
+void clock_profile_dump()
+{
+	struct clock_profile *profile;
+	uint64_t clocks_time = 0;
+	uint64_t total_time;
+	int i;
+
+	/* Avoid divisions by zero if nothing was run */
+	total_time = ctx->total_time ? ctx->total_time : 1;
+
+	/* Report time spent in each clock callback */
+	LOG_I("Clock profile: %lu steps in %lu ns\n",
+		(unsigned long)ctx->num_steps,
+		(unsigned long)ctx->total_time);
+	for (i = 0; i < ctx->num_clocks; i++) {
+		profile = &ctx->profiles[i];
+		clocks_time += profile->time;
+		LOG_I("Clock %d (%lu Hz): %lu ticks, %lu cycles, %lu wakes, "
+			"%lu ns (%.1f%%)\n", i,
+			(unsigned long)ctx->clocks[i]->rate,
+			(unsigned long)profile->num_ticks,
+			(unsigned long)profile->num_cycles,
+			(unsigned long)profile->num_wakes,
+			(unsigned long)profile->time,
+			100.0 * profile->time / total_time);
 	}
-	return a;
+
+	/* Remaining time is spent in scheduler itself */
+	if (clocks_time > ctx->total_time)
+		clocks_time = ctx->total_time;
+	LOG_I("Scheduler: %lu ns (%.1f%%)\n",
+		(unsigned long)(ctx->total_time - clocks_time),
+		100.0 * (ctx->total_time - clocks_time) / total_time);
+
+	/* Report histogram of machine cycles advanced per step */
+	for (i = 0; i < NUM_STEP_BUCKETS; i++)
+		if (ctx->step_histogram[i])
+			LOG_I("Steps of %lu-%lu cycles: %lu\n",
+				(unsigned long)(i ? 1UL << i : 0),
+				(unsigned long)((2UL << i) - 1),
+				(unsigned long)ctx->step_histogram[i]);
 }
 
-uint64_t lcm(uint64_t a, uint64_t b)
+void clock_profile_signal(int UNUSED(signum))
 {
-	return a * b / gcd(a, b);
+	/* Let each machine instance dump its profile on its next step */
+	num_dump_requests++;
 }
 
-uint64_t lcmm(int clock_index)
+void clock_profile_init()
 {
-	struct clock *clock1 = clocks[clock_index];
-	struct clock *clock2 = clocks[clock_index + 1];
+	static int initialized;
+	struct sigaction action;
 
-	if (clock_index + 2 == num_clocks)
-		return lcm(clock1->rate, clock2->rate);
+	/* Install handler once (contexts may be created by several threads) */
+	if (__sync_lock_test_and_set(&initialized, 1))
+		return;
+
+	/* Keep handler already set by host application if any */
+	if (sigaction(SIGUSR1, NULL, &action) ||
+		(action.sa_handler != SIG_DFL)) {
+		LOG_W("SIGUSR1 in use, profiles dumped on exit only!\n");
+		return;
+	}
 
-	return lcm(clock1->rate, lcmm(clock_index + 1));
+	/* Dump profiles when SIGUSR1 is received */
+	action.sa_handler = clock_profile_signal;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &action, NULL);
+}
+#endif
+
+struct clock_context *clock_create_context()
+{
+#ifdef CONFIG_CLOCK_PROFILING
+	/* Set up profile dump requests along with first context */
+	clock_profile_init();
+#endif
+
+	/* Allocate empty context (no clocks and nothing elapsed) */
+	return calloc(1, sizeof(struct clock_context));
+}
+
+void clock_set_context(struct clock_context *context)
+{
+	ctx = context;
+}
+
+void clock_destroy_context(struct clock_context *context)
+{
+	free(context);
 }
 
 void clock_add(struct clock *clock)
 {
+	bool rate_changed;
+	size_t size;
 	int i;
 
 	/* Grow clocks array and insert clock */
-	clocks = realloc(clocks, ++num_clocks * sizeof(struct clock *));
-	clocks[num_clocks - 1] = clock;
+	size = ++ctx->num_clocks * sizeof(struct clock *);
+	ctx->clocks = realloc(ctx->clocks, size);
+	ctx->clocks[ctx->num_clocks - 1] = clock;
+	clock->index = ctx->num_clocks - 1;
+
+	/* Machine rate is the fastest clock rate (every clock ticks at most
+	once per machine cycle) */
+	rate_changed = (clock->rate > ctx->machine_clock_rate);
+	if (rate_changed)
+		ctx->machine_clock_rate = clock->rate;
+
+	/* Elapsed machine cycles cannot be converted exactly to a new rate */
+	if (rate_changed && (ctx->num_elapsed_cycles != 0))
+		LOG_E("Clock rate raised after clocks started running!\n");
 
-	/* Update machine rate */
-	machine_clock_rate = (num_clocks > 1) ? lcmm(0) : clock->rate;
+	/* Update clock periods in machine cycles (whole part and fraction over
+	clock rate, so that any rate combination is handled exactly) */
+	for (i = 0; i < ctx->num_clocks; i++) {
+		ctx->clocks[i]->div = ctx->machine_clock_rate /
+			ctx->clocks[i]->rate;
+		ctx->clocks[i]->frac = ctx->machine_clock_rate %
+			ctx->clocks[i]->rate;
+	}
+
+	/* Clock starts at current cycle and is due right away */
+	clock->start_cycle = ctx->num_elapsed_cycles;
+	clock_set_num_cycles(clock, 0);
 
-	/* Update clock dividers */
-	for (i = 0; i < num_clocks; i++)
-		clocks[i]->div = machine_clock_rate / clocks[i]->rate;
+	/* Move events of queued clocks to new machine cycle units (keeping
+	their own cycle counts) and restore heap order */
+	if (rate_changed) {
+		for (i = 0; i < ctx->num_queued; i++)
+			clock_set_num_cycles(ctx->queue[i],
+				ctx->queue[i]->num_cycles);
+		for (i = ctx->num_queued / 2 - 1; i >= 0; i--)
+			clock_sift_down(i);
+	}
 
-	/* Set initial number of remaining clock cycles */
-	clock->num_remaining_cycles = 0;
+	/* Grow event queue and due clocks arrays and queue clock */
+	ctx->queue = realloc(ctx->queue, size);
+	ctx->due_clocks = realloc(ctx->due_clocks, size);
+	clock_push(clock);
 
-	/* Update machine delay between two ticks (in ns) */
-	mach_delay = NS(1) / machine_clock_rate;
+#ifdef CONFIG_CLOCK_PROFILING
+	/* Grow profiles array and clear clock profile */
+	ctx->profiles = realloc(ctx->profiles, ctx->num_clocks *
+		sizeof(struct clock_profile));
+	memset(&ctx->profiles[clock->index], 0, sizeof(struct clock_profile));
+#endif
 }
 
 void clock_reset()
 {
-	/* Initialize current cycle and start time */
-	current_cycle = 0;
-	gettimeofday(&start_time, NULL);
+	/* Initialize current cycle and start time (clock events and elapsed
+	cycles are kept as lazy devices track their own progress with them) */
+	ctx->current_cycle = 0;
+	ctx->next_pacing_cycle = ctx->machine_clock_rate / PACING_RATE;
+	clock_gettime(CLOCK_MONOTONIC, &ctx->start_time);
 }
 
 void clock_tick_all(bool handle_delay)
 {
-	unsigned int real_delay;
-	unsigned int d;
-	int num_remaining_cycles;
-	struct timeval current_time;
-	int i;
+	struct clock *clock;
+	uint64_t num_cycles;
+#ifdef CONFIG_CLOCK_PROFILING
+	uint64_t start_time = clock_profile_get_time();
+#endif
 
-	/* Tick clocks */
-	for (i = 0; i < num_clocks; i++) {
-		/* Set current clock */
-		current_clock = clocks[i];
+	/* Dequeue clocks which are due now */
+	ctx->num_due_clocks = 0;
+	while ((ctx->num_queued > 0) &&
+		(ctx->queue[0]->next_cycle == ctx->num_elapsed_cycles))
+		ctx->due_clocks[ctx->num_due_clocks++] = clock_pop();
 
-		/* Only execute clock action if there are no remaining cycles */
-		if (current_clock->num_remaining_cycles == 0)
-			current_clock->tick(current_clock->data);
+	/* Tick due clocks (actions consume cycles and delay next events) and
+	queue them again */
+	for (ctx->due_index = 0; ctx->due_index < ctx->num_due_clocks;
+		ctx->due_index++) {
+		clock = ctx->due_clocks[ctx->due_index];
+		ctx->current_clock = clock;
+		clock_set_deadline();
+#ifdef CONFIG_CLOCK_PROFILING
+		clock_profile_tick(clock);
+#else
+		clock->tick(clock->data);
+#endif
+
+		/* Sanity check (clocks should consume cycles at all times) */
+		if (clock->next_cycle == ctx->num_elapsed_cycles)
+			LOG_W("Clock action should consume cycles!\n");
+
+		clock_push(clock);
 	}
 
 	/* No clock is being ticked anymore */
-	current_clock = NULL;
-
-	/* Find minimum number of remaining cycles */
-	num_remaining_cycles = clocks[0]->num_remaining_cycles;
-	for (i = 1; i < num_clocks; i++)
-		if (clocks[i]->num_remaining_cycles < num_remaining_cycles)
-			num_remaining_cycles = clocks[i]->num_remaining_cycles;
-
-	/* Sanity check (clocks should consume cycles at all times) */
-	if (num_remaining_cycles == 0)
-		LOG_W("Clock action should consume cycles!\n");
-
-	/* Increment current cycle by min number of remaining cycles found */
-	current_cycle += num_remaining_cycles;
-
-	/* Decrement clocks remaining cycles */
-	for (i = 0; i < num_clocks; i++)
-		clocks[i]->num_remaining_cycles -= num_remaining_cycles;
-
-	/* Only sleep if delay handling is needed */
-	if (handle_delay) {
-		/* Get actual delay (in ns) */
-		gettimeofday(&current_time, NULL);
-		real_delay = NS(current_time.tv_sec - start_time.tv_sec) +
-			(current_time.tv_usec - start_time.tv_usec) * 1000;
-
-		/* Sleep to match machine delay if needed */
-		if (current_cycle * mach_delay > real_delay) {
-			d = (current_cycle * mach_delay - real_delay) / 1000;
-			usleep(d);
-		}
-	}
+	ctx->current_clock = NULL;
+
+	/* Leave already if no clock is left to schedule */
+	if (ctx->num_queued == 0)
+		return;
 
-	/* Reset current cycle and start time if needed */
-	if (current_cycle >= machine_clock_rate) {
-		if (handle_delay)
-			gettimeofday(&start_time, NULL);
-		current_cycle -= machine_clock_rate;
+	/* Get number of cycles until next event (woken clocks can be due) */
+	num_cycles = ctx->queue[0]->next_cycle - ctx->num_elapsed_cycles;
+
+	/* Advance current cycle to next event */
+	ctx->current_cycle += num_cycles;
+	ctx->num_elapsed_cycles += num_cycles;
+#ifdef CONFIG_CLOCK_PROFILING
+	clock_profile_step(num_cycles, start_time);
+#endif
+
+	/* Pace emulation once per period if delay handling is needed */
+	if (handle_delay && (ctx->current_cycle >= ctx->next_pacing_cycle))
+		clock_pace();
+
+	/* Move start time forward every emulated second */
+	if (ctx->current_cycle >= ctx->machine_clock_rate) {
+		ctx->start_time.tv_sec++;
+		ctx->current_cycle -= ctx->machine_clock_rate;
+		ctx->next_pacing_cycle =
+			(ctx->next_pacing_cycle > ctx->machine_clock_rate) ?
+			ctx->next_pacing_cycle - ctx->machine_clock_rate : 0;
 	}
 }
 
+bool clock_run_ahead()
+{
+	struct clock *clock = ctx->current_clock;
+
+	/* Current clock can run until its deadline */
+	return clock->next_cycle < clock->deadline;
+}
+
 void clock_consume(int num_cycles)
 {
-	/* Increase number of remaining clock cycles by desired amount */
-	current_clock->num_remaining_cycles += num_cycles * current_clock->div;
+	struct clock *clock = ctx->current_clock;
+
+	/* Delay next clock event by desired amount */
+	clock->num_cycles += num_cycles;
+	clock->next_cycle += num_cycles * clock->div;
+
+	/* Accumulate fractional part and carry whole machine cycles */
+	if (clock->frac) {
+		clock->rem += num_cycles * clock->frac;
+		clock->next_cycle += clock->rem / clock->rate;
+		clock->rem %= clock->rate;
+	}
 }
 
-void clock_remove_all()
+void clock_wake(struct clock *clock)
+{
+	uint64_t cycle = clock_get_cycle();
+	int i;
+
+	/* Find clock in event queue (due or ticking clocks are awake) */
+	for (i = 0; i < ctx->num_queued; i++)
+		if (ctx->queue[i] == clock)
+			break;
+
+	/* Leave already if clock is not queued or due before current cycle */
+	if ((i == ctx->num_queued) || (clock->next_cycle <= cycle))
+		return;
+
+	/* Move clock event to first clock cycle from current cycle and restore
+	heap order */
+	clock_set_num_cycles(clock, clock_get_num_cycles(clock, cycle));
+	clock_sift_up(i);
+
+	/* Ticking clock might need to stop earlier */
+	if (ctx->current_clock)
+		clock_set_deadline();
+#ifdef CONFIG_CLOCK_PROFILING
+	ctx->profiles[clock->index].num_wakes++;
+#endif
+}
+
+uint64_t clock_get_rate()
+{
+	/* Return machine clock rate (fastest clock rate) */
+	return ctx->machine_clock_rate;
+}
+
+void clock_report_speed(uint64_t num_cycles, double real_time)
+{
+	struct clock *clock;
+	double cycles;
+	int i;
+
+	/* Report emulated and nominal rate of each clock (in Hz) */
+	for (i = 0; i < ctx->num_clocks; i++) {
+		clock = ctx->clocks[i];
+		cycles = (double)num_cycles * clock->rate /
+			ctx->machine_clock_rate;
+		LOG_I("Clock %d: %.0f Hz emulated (%lu Hz nominal)\n", i,
+			cycles / real_time,
+			(unsigned long)clock->rate);
+	}
+}
+
+uint64_t clock_get_cycle()
 {
-	free(clocks);
-	clocks = NULL;
-	num_clocks = 0;
+	/* Return current machine cycle (ticking clocks can run ahead) */
+	if (ctx->current_clock)
+		return ctx->current_clock->next_cycle;
+	return ctx->num_elapsed_cycles;
 }
 
+uint64_t clock_get_sync_cycle(struct clock *clock)
+{
+	uint64_t cycle = clock_get_cycle();
+
+	/* Events happening at current cycle were already handled if clock is
+	ticked before current one (following clock registration order) */
+	if (ctx->current_clock && (clock->index < ctx->current_clock->index))
+		cycle++;
+
+	/* Return number of clock cycles occurring before machine cycle */
+	return clock_get_num_cycles(clock, cycle);
+}
+
+void clock_remove_all()
+{
+#ifdef CONFIG_CLOCK_PROFILING
+	/* Dump profile and reset it */
+	if (ctx->num_clocks > 0)
+		clock_profile_dump();
+	free(ctx->profiles);
+	ctx->profiles = NULL;
+	memset(ctx->step_histogram, 0, sizeof(ctx->step_histogram));
+	ctx->num_steps = 0;
+	ctx->total_time = 0;
+#endif
+	free(ctx->clocks);
+	free(ctx->queue);
+	free(ctx->due_clocks);
+	ctx->clocks = NULL;
+	ctx->queue = NULL;
+	ctx->due_clocks = NULL;
+	ctx->num_clocks = 0;
+	ctx->num_queued = 0;
+	ctx->machine_clock_rate = 0;
+}
@@ -5,22 +5,47 @@
 #include <list.h>
 #include <log.h>
 
+struct controller_context {
+	struct list_link *controller_instances;
+};
+
 struct list_link *controllers;
-static struct list_link *controller_instances;
+static __thread struct controller_context *ctx;
+
+struct controller_context *controller_create_context()
+{
+	/* Allocate empty context (no controller instances) */
+	return calloc(1, sizeof(struct controller_context));
+}
+
+void controller_set_context(struct controller_context *context)
+{
+	ctx = context;
+}
+
+void controller_destroy_context(struct controller_context *context)
+{
+	free(context);
+}
 
 bool controller_add(struct controller_instance *instance)
 {
 	struct list_link *link = controllers;
+	struct controller_instance *copy;
 	struct controller *c;
 
 	while ((c = list_get_next(&link)))
 		if (!strcmp(instance->controller_name, c->name)) {
-			instance->controller = c;
-			if ((c->init && c->init(instance)) || !c->init) {
-				list_insert(&controller_instances,
-					instance);
+			/* Work on a private copy as machine templates are
+			shared between machine instances */
+			copy = malloc(sizeof(struct controller_instance));
+			*copy = *instance;
+			copy->controller = c;
+			if ((c->init && c->init(copy)) || !c->init) {
+				list_insert(&ctx->controller_instances, copy);
 				return true;
 			}
+			free(copy);
 			return false;
 		}
 
@@ -31,7 +56,7 @@ bool controller_add(struct controller_instance *instance)
 
 void controller_reset_all()
 {
-	struct list_link *link = controller_instances;
+	struct list_link *link = ctx->controller_instances;
 	struct controller_instance *instance;
 
 	while ((instance = list_get_next(&link)))
@@ -41,13 +66,16 @@ void controller_reset_all()
 
 void controller_remove_all()
 {
-	struct list_link *link = controller_instances;
+	struct list_link *link = ctx->controller_instances;
 	struct controller_instance *instance;
 
-	while ((instance = list_get_next(&link)))
+	/* Deinitialize and free instances */
+	while ((instance = list_get_next(&link))) {
 		if (instance->controller->deinit)
 			instance->controller->deinit(instance);
+		free(instance);
+	}
 
-	list_remove_all(&controller_instances);
+	list_remove_all(&ctx->controller_instances);
 }
 
@@ -5,21 +5,54 @@
 #include <list.h>
 #include <log.h>
 
+struct cpu_context {
+	struct list_link *cpu_instances;
+	char *jit_mode;
+};
+
 struct list_link *cpus;
-static struct list_link *cpu_instances;
+static __thread struct cpu_context *ctx;
+
+struct cpu_context *cpu_create_context(char *jit_mode)
+{
+	struct cpu_context *context;
+
+	/* Allocate empty context (no CPU instances) and save JIT mode used
+	by its instances (CPU options are used if none is given) */
+	context = calloc(1, sizeof(struct cpu_context));
+	context->jit_mode = jit_mode;
+	return context;
+}
+
+void cpu_set_context(struct cpu_context *context)
+{
+	ctx = context;
+}
+
+void cpu_destroy_context(struct cpu_context *context)
+{
+	free(context);
+}
 
 bool cpu_add(struct cpu_instance *instance)
 {
 	struct list_link *link = cpus;
+	struct cpu_instance *copy;
 	struct cpu *cpu;
 
 	while ((cpu = list_get_next(&link)))
 		if (!strcmp(instance->cpu_name, cpu->name)) {
-			instance->cpu = cpu;
-			if ((cpu->init && cpu->init(instance)) || !cpu->init) {
-				list_insert(&cpu_instances, instance);
+			/* Work on a private copy as machine templates are
+			shared between machine instances */
+			copy = malloc(sizeof(struct cpu_instance));
+			*copy = *instance;
+			copy->jit_mode = ctx->jit_mode;
+			copy->cpu = cpu;
+			if ((cpu->init && cpu->init(copy)) || !cpu->init) {
+				list_insert(&ctx->cpu_instances, copy);
 				return true;
 			}
+			free(copy);
 			return false;
 		}
 
@@ -30,7 +63,7 @@ bool cpu_add(struct cpu_instance *instance)
 
 void cpu_reset_all()
 {
-	struct list_link *link = cpu_instances;
+	struct list_link *link = ctx->cpu_instances;
 	struct cpu_instance *instance;
 
 	while ((instance = list_get_next(&link)))
@@ -41,7 +74,7 @@ void cpu_reset_all()
 void cpu_interrupt(int irq)
 {
 	struct cpu_instance *instance;
-	struct list_link *link = cpu_instances;
+	struct list_link *link = ctx->cpu_instances;
 
 	/* Interrupt first CPU only */
 	instance = list_get_next(&link);
@@ -51,13 +84,16 @@ void cpu_interrupt(int irq)
 
 void cpu_remove_all()
 {
-	struct list_link *link = cpu_instances;
+	struct list_link *link = ctx->cpu_instances;
 	struct cpu_instance *instance;
 
-	while ((instance = list_get_next(&link)))
+	/* Deinitialize and free instances */
+	while ((instance = list_get_next(&link))) {
 		if (instance->cpu->deinit)
 			instance->cpu->deinit(instance);
+		free(instance);
+	}
 
-	list_remove_all(&cpu_instances);
+	list_remove_all(&ctx->cpu_instances);
 }
 
@@ -8,8 +8,19 @@ PARAM(system_path, string, "system-dir", NULL, "Path to system directory")
 static char *config_path = "";
 PARAM(config_path, string, "config-dir", NULL, "Path to config directory")
 
+/* Data path of currently selected machine instance (if any) */
+static __thread char *instance_data_path;
+
+void env_set_data_path(char *path)
+{
+	instance_data_path = path;
+}
+
 char *env_get_data_path()
 {
+	/* Fall back to command-line path if instance has no path of its own */
+	if (instance_data_path)
+		return instance_data_path;
 	return data_path;
 }
 
@@ -20,12 +20,32 @@
 #define DOC_KEY_NODE_NAME	"key"
 #endif
 
-struct list_link *input_frontends;
-static struct input_frontend *frontend;
-static struct list_link *listeners;
+struct input_context {
+	struct input_frontend *frontend;
+	struct list_link *listeners;
 #ifdef CONFIG_INPUT_XML
-static node_t *config_doc;
+	node_t *config_doc;
 #endif
+};
+
+struct list_link *input_frontends;
+static __thread struct input_context *ctx;
+
+struct input_context *input_create_context()
+{
+	/* Allocate empty context (no frontend and no listeners) */
+	return calloc(1, sizeof(struct input_context));
+}
+
+void input_set_context(struct input_context *context)
+{
+	ctx = context;
+}
+
+void input_destroy_context(struct input_context *context)
+{
+	free(context);
+}
 
 bool input_init(char *name)
 {
@@ -33,14 +53,14 @@ bool input_init(char *name)
 	struct input_frontend *fe;
 	video_window_t *window;
 
-	if (frontend) {
+	if (ctx->frontend) {
 		LOG_E("Input frontend already initialized!\n");
 		return false;
 	}
 
 #ifdef CONFIG_INPUT_XML
 	/* Load input configuration file */
-	config_doc = roxml_load_doc(DOC_FILENAME);
+	ctx->config_doc = roxml_load_doc(DOC_FILENAME);
 #endif
 
 	/* Get window from video frontend */
@@ -50,7 +70,7 @@ bool input_init(char *name)
 	while ((fe = list_get_next(&link)))
 		if (!strcmp(name, fe->name)) {
 			if ((fe->init && fe->init(window))) {
-				frontend = fe;
+				ctx->frontend = fe;
 				return true;
 			}
 			return false;
@@ -74,11 +94,11 @@ bool input_load(char *name, struct input_event *events, int num_events)
 	bool rc = false;
 
 	/* Check if configuration file was loaded */
-	if (!config_doc)
+	if (!ctx->config_doc)
 		goto err;
 
 	/* Find document initial node */
-	node = roxml_get_chld(config_doc, DOC_CONFIG_NODE_NAME, 0);
+	node = roxml_get_chld(ctx->config_doc, DOC_CONFIG_NODE_NAME, 0);
 	if (!node)
 		goto err;
 
@@ -134,13 +154,13 @@ err:
 
 void input_update()
 {
-	if (frontend && frontend->update)
-		frontend->update();
+	if (ctx->frontend && ctx->frontend->update)
+		ctx->frontend->update();
 }
 
 void input_report(struct input_event *event, struct input_state *state)
 {
-	struct list_link *link = listeners;
+	struct list_link *link = ctx->listeners;
 	struct input_config *config;
 	struct input_event *e;
 	int i;
@@ -169,21 +189,21 @@ void input_report(struct input_event *event, struct input_state *state)
 
 void input_register(struct input_config *config)
 {
-	list_insert(&listeners, config);
+	list_insert(&ctx->listeners, config);
 }
 
 void input_unregister(struct input_config *config)
 {
-	list_remove(&listeners, config);
+	list_remove(&ctx->listeners, config);
 }
 
 void input_deinit()
 {
-	if (frontend->deinit)
-		frontend->deinit();
-	frontend = NULL;
+	if (ctx->frontend->deinit)
+		ctx->frontend->deinit();
+	ctx->frontend = NULL;
 #ifdef CONFIG_INPUT_XML
-	roxml_close(config_doc);
+	roxml_close(ctx->config_doc);
 #endif
 }
 
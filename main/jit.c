@@ -0,0 +1,297 @@
+#if !defined(__x86_64__) || defined(_WIN32)
+#error "JIT requires an x86-64 System V host"
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <jit.h>
+#include <log.h>
+
+/* Blocks keep their data pointer in RBX (callee-saved, so it survives calls
+to handlers, which get it back in RDI) and use RAX as scratch register */
+#define PUSH_RBX		0x53
+#define POP_RBX			0x5B
+#define RET			0xC3
+#define MODRM_RBX_DISP32	0x83
+#define MODRM_RBX_DISP32_CMP	0xBB
+
+/* Condition codes (as found in short Jcc opcodes) */
+#define JAE			0x73
+#define JE			0x74
+#define JNE			0x75
+
+struct jit {
+	uint8_t *code;
+	size_t size;
+	size_t page_size;
+	size_t pos;
+	size_t block_start;
+	bool full;
+	bool failed;
+};
+
+static void jit_emit(struct jit *jit, void *data, size_t size);
+static void jit_emit8(struct jit *jit, uint8_t b);
+static void jit_emit_disp(struct jit *jit, uint8_t modrm, int offset);
+static void jit_emit_load_ptr(struct jit *jit, int offset);
+static void jit_emit_call(struct jit *jit, void *func);
+static void jit_emit_exit_if(struct jit *jit, uint8_t jcc);
+static bool jit_protect(struct jit *jit, size_t start, size_t end, int prot);
+
+void jit_emit(struct jit *jit, void *data, size_t size)
+{
+	/* Flag buffer as full (block will be discarded) if data does not fit
+	and emit nothing more until it is flushed */
+	if (jit->full || (jit->pos + size > jit->size)) {
+		jit->full = true;
+		return;
+	}
+
+	/* Copy data (x86 is little-endian, just like the host) */
+	memcpy(&jit->code[jit->pos], data, size);
+	jit->pos += size;
+}
+
+void jit_emit8(struct jit *jit, uint8_t b)
+{
+	jit_emit(jit, &b, 1);
+}
+
+void jit_emit_disp(struct jit *jit, uint8_t modrm, int offset)
+{
+	int32_t disp = offset;
+
+	/* ModRM byte addressing [rbx + disp32] */
+	jit_emit8(jit, modrm);
+	jit_emit(jit, &disp, sizeof(disp));
+}
+
+void jit_emit_load_ptr(struct jit *jit, int offset)
+{
+	/* mov rax, [rbx + disp32] */
+	jit_emit(jit, "\x48\x8B", 2);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, offset);
+}
+
+void jit_emit_call(struct jit *jit, void *func)
+{
+	uint64_t address = (uintptr_t)func;
+
+	/* mov rdi, rbx */
+	jit_emit(jit, "\x48\x89\xDF", 3);
+
+	/* mov rax, imm64 / call rax */
+	jit_emit(jit, "\x48\xB8", 2);
+	jit_emit(jit, &address, sizeof(address));
+	jit_emit(jit, "\xFF\xD0", 2);
+}
+
+void jit_emit_exit_if(struct jit *jit, uint8_t jcc)
+{
+	/* Skip over block exit (pop rbx / ret) unless condition is met */
+	jit_emit8(jit, jcc ^ 0x01);
+	jit_emit8(jit, 2);
+	jit_emit8(jit, POP_RBX);
+	jit_emit8(jit, RET);
+}
+
+bool jit_protect(struct jit *jit, size_t start, size_t end, int prot)
+{
+	/* Align range on pages (pages are never writable and executable at
+	the same time, as some systems forbid it) */
+	start -= start % jit->page_size;
+	end += (jit->page_size - end % jit->page_size) % jit->page_size;
+	if (end > jit->size)
+		end = jit->size;
+
+	if (mprotect(&jit->code[start], end - start, prot)) {
+		LOG_E("Could not change JIT code buffer protection!\n");
+		return false;
+	}
+
+	return true;
+}
+
+enum jit_mode jit_get_mode(char *name)
+{
+	/* JIT is disabled by default */
+	if (!name || !strcmp(name, "off"))
+		return JIT_OFF;
+	if (!strcmp(name, "on"))
+		return JIT_ON;
+
+	LOG_W("JIT mode \"%s\" not recognized!\n", name);
+	return JIT_OFF;
+}
+
+struct jit *jit_create(size_t size)
+{
+	struct jit *jit;
+	void *code;
+
+	/* Map code buffer (writable until blocks are made executable) */
+	code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (code == MAP_FAILED) {
+		LOG_E("Could not map JIT code buffer!\n");
+		return NULL;
+	}
+
+	/* Create empty JIT */
+	jit = calloc(1, sizeof(struct jit));
+	jit->code = code;
+	jit->size = size;
+	jit->page_size = sysconf(_SC_PAGESIZE);
+	return jit;
+}
+
+void jit_destroy(struct jit *jit)
+{
+	munmap(jit->code, jit->size);
+	free(jit);
+}
+
+void jit_flush(struct jit *jit)
+{
+	/* Discard all blocks (users should drop their block pointers) */
+	jit->pos = 0;
+	jit->full = false;
+
+	/* Make whole buffer writable again */
+	if (!jit_protect(jit, 0, jit->size, PROT_READ | PROT_WRITE))
+		jit->failed = true;
+}
+
+bool jit_failed(struct jit *jit)
+{
+	/* Buffer protection could not be changed (JIT cannot be used) */
+	return jit->failed;
+}
+
+bool jit_begin(struct jit *jit)
+{
+	/* Make unused part of buffer writable (blocks sharing its first page
+	are not run until the new block ends) */
+	if (jit->failed || !jit_protect(jit, jit->pos, jit->size,
+		PROT_READ | PROT_WRITE)) {
+		jit->failed = true;
+		return false;
+	}
+
+	/* Block prologue (keeps stack aligned on 16 bytes for calls) */
+	jit->block_start = jit->pos;
+	jit_emit8(jit, PUSH_RBX);
+
+	/* mov rbx, rdi */
+	jit_emit(jit, "\x48\x89\xFB", 3);
+	return true;
+}
+
+jit_block_t jit_end(struct jit *jit)
+{
+	jit_block_t block = NULL;
+
+	/* Block epilogue */
+	jit_emit8(jit, POP_RBX);
+	jit_emit8(jit, RET);
+
+	/* Discard block if it did not fit (buffer needs to be flushed) */
+	if (jit->full)
+		jit->pos = jit->block_start;
+	else
+		block = (jit_block_t)(void *)&jit->code[jit->block_start];
+
+	/* Make block (and others sharing its pages) executable again */
+	if (!jit_protect(jit, jit->block_start, jit->pos,
+		PROT_READ | PROT_EXEC)) {
+		jit->failed = true;
+		return NULL;
+	}
+
+	return block;
+}
+
+void jit_store8(struct jit *jit, int offset, uint8_t b)
+{
+	/* mov byte [rbx + disp32], imm8 */
+	jit_emit8(jit, 0xC6);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, offset);
+	jit_emit8(jit, b);
+}
+
+void jit_store16(struct jit *jit, int offset, uint16_t w)
+{
+	/* mov word [rbx + disp32], imm16 */
+	jit_emit(jit, "\x66\xC7", 2);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, offset);
+	jit_emit(jit, &w, sizeof(w));
+}
+
+void jit_store8_ptr(struct jit *jit, int offset, uint8_t b)
+{
+	/* Load pointer, then store byte through it (mov byte [rax], imm8) */
+	jit_emit_load_ptr(jit, offset);
+	jit_emit(jit, "\xC6\x00", 2);
+	jit_emit8(jit, b);
+}
+
+void jit_call(struct jit *jit, jit_func_t func)
+{
+	jit_emit_call(jit, (void *)func);
+}
+
+void jit_exit_unless_below(struct jit *jit, int offset, int32_t margin,
+	int limit_offset)
+{
+	/* Load qword (mov rax, [rbx + disp32]) and add margin if any (add rax,
+	imm32) */
+	jit_emit(jit, "\x48\x8B", 2);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, offset);
+	if (margin) {
+		jit_emit(jit, "\x48\x05", 2);
+		jit_emit(jit, &margin, sizeof(margin));
+	}
+
+	/* Leave block unless result is below limit (cmp rax, [rbx + disp32]) */
+	jit_emit(jit, "\x48\x3B", 2);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, limit_offset);
+	jit_emit_exit_if(jit, JAE);
+}
+
+void jit_exit_if_set(struct jit *jit, int offset)
+{
+	/* Leave block if byte is set (cmp byte [rbx + disp32], 0) */
+	jit_emit8(jit, 0x80);
+	jit_emit_disp(jit, MODRM_RBX_DISP32_CMP, offset);
+	jit_emit8(jit, 0x00);
+	jit_emit_exit_if(jit, JNE);
+}
+
+void jit_exit_if_masked(struct jit *jit, int flag_offset, int bits_offset,
+	int mask_offset)
+{
+	/* Skip check unless bits are set in mask (movzx eax, byte [rbx +
+	disp32] / and al, [rbx + disp32] / jz over flag check and exit) */
+	jit_emit(jit, "\x0F\xB6", 2);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, bits_offset);
+	jit_emit8(jit, 0x22);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, mask_offset);
+	jit_emit8(jit, JE);
+	jit_emit8(jit, 11);
+
+	/* Leave block if flag byte is set */
+	jit_exit_if_set(jit, flag_offset);
+}
+
+void jit_exit_if_changed(struct jit *jit, int ptr_offset, int value_offset)
+{
+	/* Leave block if 32-bit value pointed to differs from saved one (mov
+	eax, [rax] / cmp eax, [rbx + disp32]) */
+	jit_emit_load_ptr(jit, ptr_offset);
+	jit_emit(jit, "\x8B\x00", 2);
+	jit_emit8(jit, 0x3B);
+	jit_emit_disp(jit, MODRM_RBX_DISP32, value_offset);
+	jit_emit_exit_if(jit, JNE);
+}
@@ -1,65 +1,156 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <audio.h>
 #include <clock.h>
 #include <cmdline.h>
 #include <controller.h>
 #include <cpu.h>
+#include <env.h>
 #include <input.h>
 #include <log.h>
 #include <machine.h>
 #include <memory.h>
 #include <util.h>
+#include <video.h>
+
+/* Lowest refresh rate a frame is waited for (video may be disabled) */
+#define MIN_FRAME_RATE	50
 
 static void machine_input_event(int id,	struct input_state *state,
 	input_data_t *data);
+static void machine_benchmark();
 
 static char *machine_name;
 PARAM(machine_name, string, "machine", NULL, "Selects machine to emulate")
+static int bench_frames;
+PARAM(bench_frames, int, "benchmark", NULL,
+	"Runs unthrottled for a number of frames and reports speed")
+static int bench_seconds;
+PARAM(bench_seconds, int, "benchmark-time", NULL,
+	"Runs unthrottled for a number of emulated seconds and reports speed")
 
 struct list_link *machines;
-static struct machine *machine;
+static __thread struct machine *machine;
 
 void machine_input_event(int UNUSED(id), struct input_state *UNUSED(state),
-	input_data_t *UNUSED(data))
+	input_data_t *data)
 {
+	struct machine *m = data;
+
 	/* Request machine to stop running */
-	machine->running = false;
+	m->running = false;
 }
 
-bool machine_init()
+struct machine *machine_create(char *name, char *data_path, char *jit_mode)
 {
 	struct list_link *link = machines;
+	struct machine *selected = machine;
+	struct machine *definition;
 	struct machine *m;
 
-	/* Validate machine option */
-	if (!machine_name) {
+	/* Use machine option if no name was given */
+	if (!name)
+		name = machine_name;
+
+	/* Validate machine name */
+	if (!name) {
 		LOG_E("No machine selected!\n");
-		return false;
+		return NULL;
 	}
 
-	while ((m = list_get_next(&link)))
-		if (!strcmp(machine_name, m->name))
-			machine = m;
+	/* Find machine definition */
+	while ((definition = list_get_next(&link)))
+		if (!strcmp(name, definition->name))
+			break;
 
 	/* Exit if machine has not been found */
-	if (!machine) {
-		LOG_E("Machine \"%s\" not recognized!\n", machine_name);
-		return false;
+	if (!definition) {
+		LOG_E("Machine \"%s\" not recognized!\n", name);
+		return NULL;
 	}
 
 	/* Display machine name and description */
-	LOG_I("Machine: %s (%s)\n", machine->name, machine->description);
+	LOG_I("Machine: %s (%s)\n", definition->name,
+		definition->description);
+
+	/* Create instance from definition along with its own contexts */
+	m = malloc(sizeof(struct machine));
+	*m = *definition;
+	m->data_path = data_path;
+	m->priv_data = NULL;
+	m->running = false;
+	m->clock_context = clock_create_context();
+	m->memory_context = memory_create_context();
+	m->cpu_context = cpu_create_context(jit_mode);
+	m->controller_context = controller_create_context();
+	m->video_context = video_create_context();
+	m->input_context = input_create_context();
+	m->audio_context = audio_create_context();
+
+	/* Select instance so that components get added to it */
+	machine_select(m);
+
+	/* Initialize instance (destroying it also frees partial machine data
+	on failure) */
+	if (m->init && !m->init(m)) {
+		machine_destroy(m);
+		machine_select(selected);
+		return NULL;
+	}
+
+	return m;
+}
+
+void machine_select(struct machine *m)
+{
+	/* Point all sub-systems to instance contexts (or to none) */
+	machine = m;
+	clock_set_context(m ? m->clock_context : NULL);
+	memory_set_context(m ? m->memory_context : NULL);
+	cpu_set_context(m ? m->cpu_context : NULL);
+	controller_set_context(m ? m->controller_context : NULL);
+	video_set_context(m ? m->video_context : NULL);
+	input_set_context(m ? m->input_context : NULL);
+	audio_set_context(m ? m->audio_context : NULL);
+	env_set_data_path(m ? m->data_path : NULL);
+}
 
-	if (machine->init && !machine->init(machine)) {
-		/* Remove all components which may have been added */
-		clock_remove_all();
-		cpu_remove_all();
-		controller_remove_all();
-		memory_bus_remove_all();
+void machine_destroy(struct machine *m)
+{
+	struct machine *selected = machine;
 
+	/* Select instance to remove its components and machine data */
+	machine_select(m);
+	clock_remove_all();
+	cpu_remove_all();
+	controller_remove_all();
+	memory_bus_remove_all();
+	if (m->deinit)
+		m->deinit(m);
+
+	/* Free contexts and instance */
+	clock_destroy_context(m->clock_context);
+	memory_destroy_context(m->memory_context);
+	cpu_destroy_context(m->cpu_context);
+	controller_destroy_context(m->controller_context);
+	video_destroy_context(m->video_context);
+	input_destroy_context(m->input_context);
+	audio_destroy_context(m->audio_context);
+	free(m);
+
+	/* Restore previous selection */
+	machine_select((selected != m) ? selected : NULL);
+}
+
+bool machine_init()
+{
+	/* Create and select instance using command-line machine and path */
+	if (!machine_create(NULL, NULL, NULL)) {
 		/* Print machine-specific options */
-		cmdline_print_module_options(machine_name);
+		if (machine_name)
+			cmdline_print_module_options(machine_name);
 		return false;
 	}
 
@@ -80,6 +171,62 @@ void machine_reset()
 	LOG_I("Machine reset.\n");
 }
 
+void machine_benchmark()
+{
+	struct timespec start_time;
+	struct timespec end_time;
+	unsigned long start_frame;
+	unsigned long num_frames = 0;
+	uint64_t start_cycle;
+	uint64_t num_cycles = 0;
+	uint64_t max_cycles;
+	uint64_t max_frame_cycles;
+	double real_time;
+	double emulated_time;
+
+	/* Compute number of machine cycles to emulate (if requested) */
+	max_cycles = (uint64_t)bench_seconds * clock_get_rate();
+
+	/* Bound frame count by a frame period at the lowest refresh rate per
+	frame so that benchmark ends even while video is disabled */
+	max_frame_cycles = (uint64_t)bench_frames *
+		(clock_get_rate() / MIN_FRAME_RATE);
+
+	/* Save starting point */
+	start_frame = video_get_num_frames();
+	start_cycle = clock_get_cycle();
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	/* Run without pacing until frame or cycle count is reached */
+	while (((bench_frames <= 0) ||
+		((num_frames < (unsigned long)bench_frames) &&
+		(num_cycles < max_frame_cycles))) &&
+		((bench_seconds <= 0) || (num_cycles < max_cycles))) {
+		clock_tick_all(false);
+		num_frames = video_get_num_frames() - start_frame;
+		num_cycles = clock_get_cycle() - start_cycle;
+	}
+
+	/* Warn if video did not complete requested frames in time */
+	if ((bench_frames > 0) && (num_frames < (unsigned long)bench_frames) &&
+		(num_cycles >= max_frame_cycles))
+		LOG_W("Benchmark: video stalled after %lu frames!\n",
+			num_frames);
+
+	/* Compute real and emulated times (in seconds) */
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	real_time = (end_time.tv_sec - start_time.tv_sec) +
+		(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+	emulated_time = (double)num_cycles / clock_get_rate();
+
+	/* Report results */
+	LOG_I("Benchmark: %lu frames (%.3fs emulated) in %.3fs\n", num_frames,
+		emulated_time, real_time);
+	LOG_I("Benchmark: %.2f frames/s, %.2fx real time\n",
+		num_frames / real_time, emulated_time / real_time);
+	clock_report_speed(num_cycles, real_time);
+}
+
 void machine_run()
 {
 	struct input_config input_config;
@@ -88,12 +235,19 @@ void machine_run()
 	/* Reset machine first */
 	machine_reset();
 
+	/* Run benchmark instead if requested */
+	if ((bench_frames > 0) || (bench_seconds > 0)) {
+		machine_benchmark();
+		return;
+	}
+
 	/* Set running flag and register for quit events */
 	machine->running = true;
 	quit_event.type = EVENT_QUIT;
 	input_config.events = &quit_event;
 	input_config.num_events = 1;
 	input_config.callback = machine_input_event;
+	input_config.data = machine;
 	input_register(&input_config);
 
 	/* Run until user quits */
@@ -110,13 +264,28 @@ void machine_step()
 	clock_tick_all(false);
 }
 
-void machine_deinit()
+bool machine_run_frame()
 {
-	clock_remove_all();
-	cpu_remove_all();
-	controller_remove_all();
-	memory_bus_remove_all();
-	if (machine && machine->deinit)
-		machine->deinit(machine);
+	unsigned long frame = video_get_num_frames();
+	uint64_t max_cycle;
+
+	/* Give up after a frame period at the lowest refresh rate so that
+	callers keep running at a steady pace while video is disabled */
+	max_cycle = clock_get_cycle() + clock_get_rate() / MIN_FRAME_RATE;
+
+	/* Step with no delay handling until video completes a frame (vblank) */
+	while (video_get_num_frames() == frame) {
+		if (clock_get_cycle() >= max_cycle)
+			return false;
+		clock_tick_all(false);
+	}
+
+	return true;
 }
 
+void machine_deinit()
+{
+	/* Destroy selected instance */
+	if (machine)
+		machine_destroy(machine);
+}
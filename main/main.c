@@ -2,9 +2,13 @@
 #include <time.h>
 #include <unistd.h>
 #include <cmdline.h>
+#include <config.h>
 #include <env.h>
 #include <log.h>
 #include <machine.h>
+#ifdef CONFIG_RUNNER
+#include <runner.h>
+#endif
 
 #if (defined(CONFIG_AUDIO_SDL) || defined(CONFIG_VIDEO_SDL)) && \
 	defined(__APPLE__)
@@ -35,6 +39,12 @@ int main(int argc, char *argv[])
 		goto err;
 	}
 
+#ifdef CONFIG_RUNNER
+	/* Run headless instances through runner if requested */
+	if (runner_requested())
+		return runner_run_all() ? 0 : 1;
+#endif
+
 	/* Initialize, run, and deinitialize machine */
 	if (!machine_init())
 		goto err;
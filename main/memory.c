@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -11,15 +12,14 @@
 #include <sys/stat.h>
 #endif
 #include <bitops.h>
+#include <clock.h>
+#include <cmdline.h>
 #include <log.h>
 #include <memory.h>
 #include <util.h>
 
-struct bus {
-	int width;
-	struct region *regions;
-	int num_regions;
-};
+/* Number of accesses kept by default watch hook */
+#define TRACE_BUFFER_SIZE	1024
 
 struct region {
 	address_t start;
@@ -28,6 +28,20 @@ struct region {
 	region_data_t *data;
 };
 
+struct watch {
+	address_t start;
+	address_t end;
+	uint8_t flags;
+};
+
+struct memory_context {
+	struct bus *busses;
+	int num_busses;
+	watch_hook_t watch_hook;
+	struct trace_entry trace_buffer[TRACE_BUFFER_SIZE];
+	unsigned long num_trace_entries;
+};
+
 static uint8_t rom_readb(region_data_t *data, address_t address);
 static uint16_t rom_readw(region_data_t *data, address_t address);
 static uint8_t ram_readb(region_data_t *data, address_t address);
@@ -37,9 +51,36 @@ static void ram_writew(region_data_t *data, uint16_t w, address_t address);
 static int memory_region_sort_compare(const void *a, const void *b);
 static int memory_region_bsearch_compare(const void *key, const void *elem);
 static struct region *memory_region_find(int bus_id, address_t *address);
-
-static struct bus *busses;
-static int num_busses;
+static struct region *memory_region_get(struct bus *bus,
+	struct resource *area);
+static struct page *memory_bus_get_page(struct bus *bus, int index);
+static void memory_bus_set_page(struct bus *bus, int index,
+	struct region *region);
+static void memory_bus_update_page(struct bus *bus, int index);
+static void memory_bus_update_region_pages(struct bus *bus,
+	struct region *region);
+static void memory_bus_stage(struct bus *bus);
+static void memory_bus_commit(struct bus *bus);
+static void memory_bus_unmapped(int bus_id, address_t address);
+static void memory_bus_report(int bus_id);
+static uint8_t memory_bus_readb(int bus_id, address_t address);
+static void memory_bus_watch(int bus_id, address_t address, int size,
+	uint16_t value, uint8_t type);
+static void memory_bus_update_watch_pages(struct bus *bus, address_t start,
+	address_t end);
+static void memory_bus_parse_watches(int bus_id);
+static void memory_trace_record(int bus_id, address_t address, uint16_t value,
+	uint8_t type);
+static void memory_trace_dump();
+
+__thread struct bus *busses;
+static __thread struct memory_context *ctx;
+static struct page empty_table[BUS_TABLE_SIZE];
+
+/* Command-line parameter */
+static char *watch_list;
+PARAM(watch_list, string, "watch", NULL,
+	"Watches memory accesses (bus:start-end[:rwx],...)")
 
 struct mops rom_mops = {
 	.readb = rom_readb,
@@ -122,17 +163,26 @@ int memory_region_bsearch_compare(const void *key, const void *elem)
 
 struct region *memory_region_find(int bus_id, address_t *address)
 {
+	struct bus *bus = &busses[bus_id];
 	struct region *region;
 
+	/* Commit staged region changes if needed */
+	if (bus->dirty)
+		memory_bus_commit(bus);
+
 	/* Make sure address fits within bus */
-	*address &= (BIT(busses[bus_id].width) - 1);
+	*address &= bus->mask;
 
-	/* Search region */
-	region = bsearch(address,
-		busses[bus_id].regions,
-		busses[bus_id].num_regions,
-		sizeof(struct region),
-		memory_region_bsearch_compare);
+	/* Get region from page table (only set if it covers the whole page) */
+	region = memory_bus_page(bus, *address)->region;
+
+	/* Search region if page is shared between regions or unmapped */
+	if (!region)
+		region = bsearch(address,
+			bus->regions,
+			bus->num_regions,
+			sizeof(struct region),
+			memory_region_bsearch_compare);
 
 	/* Adapt address if a region was found */
 	if (region)
@@ -141,15 +191,238 @@ struct region *memory_region_find(int bus_id, address_t *address)
 	return region;
 }
 
+struct region *memory_region_get(struct bus *bus, struct resource *area)
+{
+	address_t start = area->data.mem.start & bus->mask;
+	address_t end = area->data.mem.end & bus->mask;
+	struct region *region;
+	int i;
+
+	/* Search region if array is sorted */
+	if (!bus->dirty) {
+		region = bsearch(&start,
+			bus->regions,
+			bus->num_regions,
+			sizeof(struct region),
+			memory_region_bsearch_compare);
+		if (region && (region->start == start) && (region->end == end))
+			return region;
+		return NULL;
+	}
+
+	/* Find region matching area boundaries otherwise */
+	for (i = 0; i < bus->num_regions; i++)
+		if ((bus->regions[i].start == start) &&
+			(bus->regions[i].end == end))
+			return &bus->regions[i];
+
+	return NULL;
+}
+
+struct page *memory_bus_get_page(struct bus *bus, int index)
+{
+	struct page **table = &bus->tables[index >> BUS_TABLE_BITS];
+
+	/* Allocate table on first write (unused ones share the empty table) */
+	if (*table == empty_table)
+		*table = calloc(BUS_TABLE_SIZE, sizeof(struct page));
+
+	return &(*table)[index & BUS_TABLE_MASK];
+}
+
+void memory_bus_set_page(struct bus *bus, int index, struct region *region)
+{
+	address_t start = (address_t)index << BUS_PAGE_BITS;
+	struct page *page;
+	uint8_t *mem;
+
+	/* Leave unallocated tables alone if page is not cached */
+	if (!region && (bus->tables[index >> BUS_TABLE_BITS] == empty_table))
+		return;
+
+	/* Reset page (letting users caching page contents know about it) */
+	page = memory_bus_get_page(bus, index);
+	bus->generation++;
+	page->region = region;
+	page->read_mem = NULL;
+	page->write_mem = NULL;
+	if (!region)
+		return;
+
+	/* Plain memory can be accessed directly (bypassing mops) */
+	mem = (uint8_t *)region->data + (start - region->start);
+	if ((region->mops == &rom_mops) || (region->mops == &ram_mops))
+		page->read_mem = mem;
+	if (region->mops == &ram_mops)
+		page->write_mem = mem;
+
+	/* Watched pages are routed through the slow path */
+	if (page->watch & (WATCH_READ | WATCH_EXEC))
+		page->read_mem = NULL;
+	if (page->watch & WATCH_WRITE)
+		page->write_mem = NULL;
+}
+
+void memory_bus_update_page(struct bus *bus, int index)
+{
+	struct region *region;
+	address_t start;
+	address_t end;
+
+	/* Compute page boundaries (last page may exceed small busses) */
+	start = (address_t)index << BUS_PAGE_BITS;
+	end = start + BUS_PAGE_MASK;
+	if (end > bus->mask)
+		end = bus->mask;
+
+	/* Find region containing page start address */
+	region = bsearch(&start,
+		bus->regions,
+		bus->num_regions,
+		sizeof(struct region),
+		memory_region_bsearch_compare);
+
+	/* Only cache region if it spans the whole page */
+	if (region && (region->end < end))
+		region = NULL;
+
+	memory_bus_set_page(bus, index, region);
+}
+
+void memory_bus_update_region_pages(struct bus *bus, struct region *region)
+{
+	address_t start;
+	address_t end;
+	int first_page;
+	int last_page;
+	int i;
+
+	/* Get pages overlapping region */
+	first_page = region->start >> BUS_PAGE_BITS;
+	last_page = region->end >> BUS_PAGE_BITS;
+
+	for (i = first_page; i <= last_page; i++) {
+		/* Compute page boundaries (last page may exceed small busses) */
+		start = (address_t)i << BUS_PAGE_BITS;
+		end = start + BUS_PAGE_MASK;
+		if (end > bus->mask)
+			end = bus->mask;
+
+		/* Pages shared with other regions need a full update */
+		if ((start < region->start) || (end > region->end)) {
+			memory_bus_update_page(bus, i);
+			continue;
+		}
+
+		/* Page is fully covered by region */
+		memory_bus_set_page(bus, i, region);
+	}
+}
+
+void memory_bus_stage(struct bus *bus)
+{
+	struct page *page;
+	int i;
+	int j;
+
+	/* Leave already if bus is already staging changes */
+	if (bus->dirty)
+		return;
+
+	/* Route all accesses to the slow path until changes are committed
+	(unmapped access counters are kept) */
+	for (i = 0; i < bus->num_tables; i++) {
+		if (bus->tables[i] == empty_table)
+			continue;
+		for (j = 0; j < BUS_TABLE_SIZE; j++) {
+			page = &bus->tables[i][j];
+			page->region = NULL;
+			page->read_mem = NULL;
+			page->write_mem = NULL;
+		}
+	}
+	bus->generation++;
+	bus->dirty = true;
+}
+
+void memory_bus_commit(struct bus *bus)
+{
+	int i;
+
+	/* Sort memory regions array */
+	qsort(bus->regions, bus->num_regions, sizeof(struct region),
+		memory_region_sort_compare);
+
+	/* Rebuild page table (only pages covered by regions need updates as
+	all pages were cleared when staging) */
+	for (i = 0; i < bus->num_regions; i++)
+		memory_bus_update_region_pages(bus, &bus->regions[i]);
+
+	bus->dirty = false;
+}
+
+struct memory_context *memory_create_context()
+{
+	struct memory_context *context;
+
+	/* Allocate empty context (accesses to watched areas are traced) */
+	context = calloc(1, sizeof(struct memory_context));
+	context->watch_hook = memory_trace_record;
+	return context;
+}
+
+void memory_set_context(struct memory_context *context)
+{
+	/* Select context and point accessors to its busses */
+	ctx = context;
+	busses = context ? context->busses : NULL;
+}
+
+void memory_destroy_context(struct memory_context *context)
+{
+	free(context);
+}
+
 void memory_bus_add(int width)
 {
+	struct bus *bus;
+	int i;
+
 	/* Grow busses array */
-	busses = realloc(busses, ++num_busses * sizeof(struct bus));
+	busses = realloc(busses, ++ctx->num_busses * sizeof(struct bus));
+	ctx->busses = busses;
+
+	/* Make sure address type can hold bus addresses */
+	if (width > ADDRESS_BITS) {
+		LOG_E("Bus width %u is not supported!\n", width);
+		width = ADDRESS_BITS;
+	}
 
 	/* Initialize bus */
-	busses[num_busses - 1].width = width;
-	busses[num_busses - 1].regions = NULL;
-	busses[num_busses - 1].num_regions = 0;
+	bus = &busses[ctx->num_busses - 1];
+	bus->width = width;
+	bus->mask = (address_t)~0 >> (ADDRESS_BITS - width);
+	bus->regions = NULL;
+	bus->num_regions = 0;
+	bus->max_regions = 0;
+	bus->dirty = false;
+	bus->generation = 0;
+	bus->open_bus = 0;
+
+	/* Allocate first level of page table (each table covers 64KB) */
+	bus->num_tables = (width > BUS_PAGE_BITS + BUS_TABLE_BITS) ?
+		BIT(width - BUS_PAGE_BITS - BUS_TABLE_BITS) : 1;
+	bus->tables = malloc(bus->num_tables * sizeof(struct page *));
+	for (i = 0; i < bus->num_tables; i++)
+		bus->tables[i] = empty_table;
+
+	/* First table is always allocated (used directly by 16-bit busses) */
+	bus->pages = memory_bus_get_page(bus, 0);
+
+	/* Add watches requested for this bus */
+	bus->watches = NULL;
+	bus->num_watches = 0;
+	memory_bus_parse_watches(ctx->num_busses - 1);
 }
 
 void memory_region_add(struct resource *area, struct mops *mops,
@@ -159,118 +432,546 @@ void memory_region_add(struct resource *area, struct mops *mops,
 	struct region *region;
 	int i;
 
-	/* Get bus based on area */
+	/* Get bus based on area and stage changes */
 	bus = &busses[area->data.mem.bus_id];
+	memory_bus_stage(bus);
 
-	/* Grow memory regions array */
-	bus->regions = realloc(bus->regions, ++bus->num_regions *
-		sizeof(struct region));
+	/* Grow memory regions array if needed */
+	if (bus->num_regions == bus->max_regions) {
+		bus->max_regions = bus->max_regions ? 2 * bus->max_regions : 8;
+		bus->regions = realloc(bus->regions, bus->max_regions *
+			sizeof(struct region));
+	}
 
-	/* Create memory region */
-	region = &bus->regions[bus->num_regions - 1];
-	region->start = area->data.mem.start & (BIT(bus->width) - 1);
-	region->end = area->data.mem.end & (BIT(bus->width) - 1);
+	/* Create memory region (sorting is deferred until commit) */
+	region = &bus->regions[bus->num_regions++];
+	region->start = area->data.mem.start & bus->mask;
+	region->end = area->data.mem.end & bus->mask;
 	region->mops = mops;
 	region->data = data;
 
 	/* Add mirrors */
 	for (i = 0; i < area->num_children; i++)
 		memory_region_add(&area->children[i], mops, data);
-
-	/* Sort memory regions array */
-	qsort(bus->regions, bus->num_regions, sizeof(struct region),
-		memory_region_sort_compare);
 }
 
 void memory_region_remove(struct resource *area)
 {
 	struct bus *bus;
-	address_t start;
-	address_t end;
-	int index;
+	struct region *region;
 
 	/* Get bus based on area */
 	bus = &busses[area->data.mem.bus_id];
 
-	/* Get region start and end addresses */
-	start = area->data.mem.start;
-	end = area->data.mem.end;
+	/* Find region to remove and return if it was not found */
+	region = memory_region_get(bus, area);
+	if (!region)
+		return;
+
+	/* Stage changes and replace region with last one */
+	memory_bus_stage(bus);
+	*region = bus->regions[--bus->num_regions];
+}
+
+void memory_region_swap(struct resource *area, struct mops *mops,
+	region_data_t *data)
+{
+	struct bus *bus;
+	struct region *region;
+	int i;
 
-	/* Find region to remove */
-	for (index = 0; index < bus->num_regions; index++)
-		if ((bus->regions[index].start == start) &&
-			(bus->regions[index].end == end))
-			break;
+	/* Get bus based on area */
+	bus = &busses[area->data.mem.bus_id];
 
-	/* Return if region was not found */
-	if (index == bus->num_regions)
+	/* Find region to update and return if it was not found */
+	region = memory_region_get(bus, area);
+	if (!region)
 		return;
 
-	/* Shift remaining regions */
-	while (index < bus->num_regions - 1) {
-		bus->regions[index] = bus->regions[index + 1];
-		index++;
-	}
+	/* Swap region operations and data in place */
+	region->mops = mops;
+	region->data = data;
 
-	/* Shrink memory regions array */
-	bus->regions = realloc(bus->regions, --bus->num_regions *
-		sizeof(struct region));
+	/* Refresh pages covered by region (no need if bus is staging) */
+	if (!bus->dirty)
+		memory_bus_update_region_pages(bus, region);
+
+	/* Swap mirrors */
+	for (i = 0; i < area->num_children; i++)
+		memory_region_swap(&area->children[i], mops, data);
+}
+
+void memory_region_rebind(struct resource *area, region_data_t *data)
+{
+	struct bus *bus;
+	struct region *region;
+	int i;
+
+	/* Get bus based on area */
+	bus = &busses[area->data.mem.bus_id];
+
+	/* Find region to update and return if it was not found */
+	region = memory_region_get(bus, area);
+	if (!region)
+		return;
+
+	/* Point region to its new bank */
+	region->data = data;
+
+	/* Refresh pages covered by region (no need if bus is staging) */
+	if (!bus->dirty)
+		memory_bus_update_region_pages(bus, region);
+
+	/* Rebind mirrors */
+	for (i = 0; i < area->num_children; i++)
+		memory_region_rebind(&area->children[i], data);
+}
+
+void memory_bus_report(int bus_id)
+{
+	struct bus *bus = &busses[bus_id];
+	struct page *page;
+	address_t start;
+	int i;
+	int j;
+
+	/* Report unmapped access totals per page (of allocated tables) */
+	for (i = 0; i < bus->num_tables; i++) {
+		if (bus->tables[i] == empty_table)
+			continue;
+		for (j = 0; j < BUS_TABLE_SIZE; j++) {
+			page = &bus->tables[i][j];
+			if (page->num_unmapped_accesses == 0)
+				continue;
+			start = (address_t)((i << BUS_TABLE_BITS) | j) <<
+				BUS_PAGE_BITS;
+			LOG_W("%lu unmapped accesses at (%u, %04x-%04x).\n",
+				page->num_unmapped_accesses,
+				bus_id,
+				start,
+				(start + BUS_PAGE_MASK) & bus->mask);
+		}
+	}
 }
 
 void memory_bus_remove_all()
 {
 	int i;
-	for (i = 0; i < num_busses; i++)
+	int j;
+	for (i = 0; i < ctx->num_busses; i++) {
+		memory_bus_report(i);
+		for (j = 0; j < busses[i].num_tables; j++)
+			if (busses[i].tables[j] != empty_table)
+				free(busses[i].tables[j]);
+		free(busses[i].tables);
 		free(busses[i].regions);
+		free(busses[i].watches);
+	}
+	memory_trace_dump();
 	free(busses);
 	busses = NULL;
-	num_busses = 0;
+	ctx->busses = NULL;
+	ctx->num_busses = 0;
+}
+
+void memory_bus_unmapped(int bus_id, address_t address)
+{
+	struct page *page;
+
+	/* Only report first access to a page (others are counted) */
+	page = memory_bus_get_page(&busses[bus_id], address >> BUS_PAGE_BITS);
+	if (page->num_unmapped_accesses++ == 0)
+		LOG_W("No region found at (%u, %04x)!\n", bus_id, address);
 }
 
-uint8_t memory_readb(int bus_id, address_t address)
+uint8_t memory_bus_readb(int bus_id, address_t address)
 {
-	struct region *region = memory_region_find(bus_id, &address);
+	struct bus *bus = &busses[bus_id];
+	address_t offset = address;
+	struct region *region = memory_region_find(bus_id, &offset);
 
 	if (region && region->mops->readb)
-		return region->mops->readb(region->data, address);
+		return bus->open_bus = region->mops->readb(region->data, offset);
 
-	LOG_W("No region found at (%u, %04x)!\n", bus_id, address);
-	return 0;
+	/* Unmapped reads return last value seen on the bus */
+	memory_bus_unmapped(bus_id, address & bus->mask);
+	return bus->open_bus;
+}
+
+uint8_t memory_region_readb(int bus_id, address_t address)
+{
+	uint8_t b = memory_bus_readb(bus_id, address);
+	memory_bus_watch(bus_id, address, 1, b, WATCH_READ);
+	return b;
+}
+
+uint8_t memory_region_fetchb(int bus_id, address_t address)
+{
+	uint8_t b = memory_bus_readb(bus_id, address);
+	memory_bus_watch(bus_id, address, 1, b, WATCH_EXEC);
+	return b;
 }
 
-uint16_t memory_readw(int bus_id, address_t address)
+uint16_t memory_region_readw(int bus_id, address_t address)
 {
-	struct region *region = memory_region_find(bus_id, &address);
+	struct bus *bus = &busses[bus_id];
+	address_t offset = address;
+	struct region *region = memory_region_find(bus_id, &offset);
+	uint16_t w;
+
+	if (region && region->mops->readw) {
+		w = region->mops->readw(region->data, offset);
+		bus->open_bus = w >> 8;
+	} else {
+		/* Unmapped reads return last value seen on the bus */
+		memory_bus_unmapped(bus_id, address & bus->mask);
+		w = (bus->open_bus << 8) | bus->open_bus;
+	}
 
-	if (region && region->mops->readw)
-		return region->mops->readw(region->data, address);
+	memory_bus_watch(bus_id, address, 2, w, WATCH_READ);
+	return w;
+}
 
-	LOG_W("No region found at (%u, %04x)!\n", bus_id, address);
-	return 0;
+void memory_region_writeb(int bus_id, uint8_t b, address_t address)
+{
+	struct bus *bus = &busses[bus_id];
+	address_t offset = address;
+	struct region *region = memory_region_find(bus_id, &offset);
+
+	bus->open_bus = b;
+	if (region && region->mops->writeb)
+		region->mops->writeb(region->data, b, offset);
+	else
+		memory_bus_unmapped(bus_id, address & bus->mask);
+
+	memory_bus_watch(bus_id, address, 1, b, WATCH_WRITE);
 }
 
-void memory_writeb(int bus_id, uint8_t b, address_t address)
+void memory_region_writew(int bus_id, uint16_t w, address_t address)
 {
-	struct region *region = memory_region_find(bus_id, &address);
+	struct bus *bus = &busses[bus_id];
+	address_t offset = address;
+	struct region *region = memory_region_find(bus_id, &offset);
+
+	bus->open_bus = w >> 8;
+	if (region && region->mops->writew)
+		region->mops->writew(region->data, w, offset);
+	else
+		memory_bus_unmapped(bus_id, address & bus->mask);
 
-	if (region && region->mops->writeb) {
-		region->mops->writeb(region->data, b, address);
+	memory_bus_watch(bus_id, address, 2, w, WATCH_WRITE);
+}
+
+void memory_read_block(int bus_id, address_t address, uint8_t *buf, int size)
+{
+	struct region *region;
+	address_t offset;
+	address_t last;
+	int len;
+	int i;
+
+	while (size > 0) {
+		/* Find region once for the whole contiguous run */
+		offset = address;
+		region = memory_region_find(bus_id, &offset);
+
+		/* Handle unmapped, unreadable or watched location byte per byte */
+		if (!region || !region->mops->readb || busses[bus_id].num_watches) {
+			*buf++ = memory_region_readb(bus_id, address++);
+			size--;
+			continue;
+		}
+
+		/* Compute run length (bounded by region end) */
+		last = region->end - region->start - offset;
+		len = (last < (address_t)(size - 1)) ? (int)last + 1 : size;
+
+		/* Copy plain memory directly and use mops otherwise */
+		if ((region->mops == &rom_mops) || (region->mops == &ram_mops))
+			memcpy(buf, (uint8_t *)region->data + offset, len);
+		else
+			for (i = 0; i < len; i++)
+				buf[i] = region->mops->readb(region->data,
+					offset + i);
+		busses[bus_id].open_bus = buf[len - 1];
+
+		buf += len;
+		address += len;
+		size -= len;
+	}
+}
+
+void memory_write_block(int bus_id, address_t address, uint8_t *buf, int size)
+{
+	struct region *region;
+	address_t offset;
+	address_t last;
+	int len;
+	int i;
+
+	while (size > 0) {
+		/* Find region once for the whole contiguous run */
+		offset = address;
+		region = memory_region_find(bus_id, &offset);
+
+		/* Handle unmapped, unwritable or watched location byte per byte */
+		if (!region || !region->mops->writeb || busses[bus_id].num_watches) {
+			memory_region_writeb(bus_id, *buf++, address++);
+			size--;
+			continue;
+		}
+
+		/* Compute run length (bounded by region end) */
+		last = region->end - region->start - offset;
+		len = (last < (address_t)(size - 1)) ? (int)last + 1 : size;
+
+		/* Copy plain memory directly and use mops otherwise */
+		if (region->mops == &ram_mops)
+			memcpy((uint8_t *)region->data + offset, buf, len);
+		else
+			for (i = 0; i < len; i++)
+				region->mops->writeb(region->data, buf[i],
+					offset + i);
+		busses[bus_id].open_bus = buf[len - 1];
+
+		buf += len;
+		address += len;
+		size -= len;
+	}
+}
+
+void memory_write_port(int bus_id, address_t address, uint8_t *buf, int size)
+{
+	struct region *region;
+	address_t offset = address;
+	int i;
+
+	/* Find port region once */
+	region = memory_region_find(bus_id, &offset);
+
+	/* Fall back to regular writes if port is missing or watched */
+	if (!region || !region->mops->writeb || busses[bus_id].num_watches) {
+		for (i = 0; i < size; i++)
+			memory_region_writeb(bus_id, buf[i], address);
 		return;
 	}
 
-	LOG_W("No region found at (%u, %04x)!\n", bus_id, address);
+	/* Feed all bytes to the same port address */
+	for (i = 0; i < size; i++)
+		region->mops->writeb(region->data, buf[i], offset);
+	if (size > 0)
+		busses[bus_id].open_bus = buf[size - 1];
+}
+
+void memory_copy_block(int dest_bus_id, address_t dest, int src_bus_id,
+	address_t src, int size)
+{
+	uint8_t buf[BUS_PAGE_SIZE];
+	int len;
+
+	/* Transfer data in page-sized chunks */
+	while (size > 0) {
+		len = (size > BUS_PAGE_SIZE) ? BUS_PAGE_SIZE : size;
+		memory_read_block(src_bus_id, src, buf, len);
+		memory_write_block(dest_bus_id, dest, buf, len);
+		src += len;
+		dest += len;
+		size -= len;
+	}
 }
 
-void memory_writew(int bus_id, uint16_t w, address_t address)
+void memory_bus_watch(int bus_id, address_t address, int size,
+	uint16_t value, uint8_t type)
 {
-	struct region *region = memory_region_find(bus_id, &address);
+	struct bus *bus = &busses[bus_id];
+	struct watch *watch;
+	address_t a;
+	int i;
+	int j;
+
+	/* Check each accessed byte (word accesses can span watch or page
+	boundaries) */
+	address &= bus->mask;
+	for (i = 0; i < size; i++) {
+		/* Skip byte if its page is not watched for this access type */
+		a = (address + i) & bus->mask;
+		if (!(memory_bus_page(bus, a)->watch & type))
+			continue;
+
+		/* Call hook once if byte matches a watch */
+		for (j = 0; j < bus->num_watches; j++) {
+			watch = &bus->watches[j];
+			if ((a >= watch->start) && (a <= watch->end) &&
+				(watch->flags & type)) {
+				ctx->watch_hook(bus_id, address, value, type);
+				return;
+			}
+		}
+	}
+}
 
-	if (region && region->mops->writew) {
-		region->mops->writew(region->data, w, address);
+void memory_bus_update_watch_pages(struct bus *bus, address_t start,
+	address_t end)
+{
+	struct page *page;
+	struct watch *watch;
+	address_t page_start;
+	address_t page_end;
+	int first_page;
+	int last_page;
+	int i;
+	int j;
+
+	/* Get pages overlapping range */
+	first_page = start >> BUS_PAGE_BITS;
+	last_page = end >> BUS_PAGE_BITS;
+
+	for (i = first_page; i <= last_page; i++) {
+		/* Compute page boundaries */
+		page_start = (address_t)i << BUS_PAGE_BITS;
+		page_end = page_start + BUS_PAGE_MASK;
+
+		/* Merge flags of all watches overlapping page */
+		page = memory_bus_get_page(bus, i);
+		page->watch = 0;
+		for (j = 0; j < bus->num_watches; j++) {
+			watch = &bus->watches[j];
+			if ((watch->start <= page_end) &&
+				(watch->end >= page_start))
+				page->watch |= watch->flags;
+		}
+
+		/* Refresh page (done on commit if bus is staging) */
+		if (!bus->dirty)
+			memory_bus_update_page(bus, i);
+	}
+}
+
+void memory_bus_parse_watches(int bus_id)
+{
+	char *list;
+	char *token;
+	char *saveptr;
+	char flags_str[4];
+	unsigned int id;
+	unsigned int start;
+	unsigned int end;
+	uint8_t flags;
+	int n;
+
+	/* Leave already if no watch was requested */
+	if (!watch_list)
 		return;
+
+	/* Parse comma-separated watch list (bus:start-end[:rwx]), keeping
+	tokenizer state local as busses may be added from several threads */
+	list = strdup(watch_list);
+	for (token = strtok_r(list, ",", &saveptr); token;
+		token = strtok_r(NULL, ",", &saveptr)) {
+		n = sscanf(token, "%u:%x-%x:%3s", &id, &start, &end, flags_str);
+		if (n < 3) {
+			LOG_E("Invalid watch \"%s\"!\n", token);
+			continue;
+		}
+
+		/* Skip watches of other busses */
+		if (id != (unsigned int)bus_id)
+			continue;
+
+		/* Watch all access types if none are specified */
+		flags = 0;
+		if (n == 3)
+			flags = WATCH_READ | WATCH_WRITE | WATCH_EXEC;
+		else {
+			if (strchr(flags_str, 'r'))
+				flags |= WATCH_READ;
+			if (strchr(flags_str, 'w'))
+				flags |= WATCH_WRITE;
+			if (strchr(flags_str, 'x'))
+				flags |= WATCH_EXEC;
+		}
+
+		memory_watch_add(bus_id, start, end, flags);
 	}
+	free(list);
+}
+
+void memory_watch_add(int bus_id, address_t start, address_t end,
+	uint8_t flags)
+{
+	struct bus *bus = &busses[bus_id];
+	struct watch *watch;
+
+	/* Grow watches array and insert watch */
+	bus->watches = realloc(bus->watches, ++bus->num_watches *
+		sizeof(struct watch));
+	watch = &bus->watches[bus->num_watches - 1];
+	watch->start = start & bus->mask;
+	watch->end = end & bus->mask;
+	watch->flags = flags;
+
+	/* Route watched pages through the slow path */
+	memory_bus_update_watch_pages(bus, watch->start, watch->end);
+}
+
+void memory_watch_remove(int bus_id, address_t start, address_t end)
+{
+	struct bus *bus = &busses[bus_id];
+	int i;
+
+	/* Remove watches matching range (replacing them with last one) */
+	start &= bus->mask;
+	end &= bus->mask;
+	for (i = bus->num_watches - 1; i >= 0; i--)
+		if ((bus->watches[i].start == start) &&
+			(bus->watches[i].end == end))
+			bus->watches[i] = bus->watches[--bus->num_watches];
+
+	/* Restore fast path for pages which are not watched anymore */
+	memory_bus_update_watch_pages(bus, start, end);
+}
+
+void memory_watch_set_hook(watch_hook_t hook)
+{
+	/* Restore default hook (tracing accesses) if needed */
+	ctx->watch_hook = hook ? hook : memory_trace_record;
+}
+
+void memory_trace_record(int bus_id, address_t address, uint16_t value,
+	uint8_t type)
+{
+	struct trace_entry *entry;
+	int i;
 
-	LOG_W("No region found at (%u, %04x)!\n", bus_id, address);
+	/* Overwrite oldest entry once ring buffer is full */
+	i = ctx->num_trace_entries++ % TRACE_BUFFER_SIZE;
+	entry = &ctx->trace_buffer[i];
+	entry->cycle = clock_get_cycle();
+	entry->bus_id = bus_id;
+	entry->address = address;
+	entry->value = value;
+	entry->type = type;
+}
+
+void memory_trace_dump()
+{
+	struct trace_entry *entry;
+	unsigned long i;
+
+	/* Print recorded accesses from oldest to newest */
+	i = (ctx->num_trace_entries > TRACE_BUFFER_SIZE) ?
+		ctx->num_trace_entries - TRACE_BUFFER_SIZE : 0;
+	for (; i < ctx->num_trace_entries; i++) {
+		entry = &ctx->trace_buffer[i % TRACE_BUFFER_SIZE];
+		LOG_I("%llu: %c (%u, %04x) %04x\n",
+			(unsigned long long)entry->cycle,
+			(entry->type == WATCH_READ) ? 'r' :
+			(entry->type == WATCH_WRITE) ? 'w' : 'x',
+			entry->bus_id,
+			entry->address,
+			entry->value);
+	}
+	ctx->num_trace_entries = 0;
 }
 
 void *memory_map_file(char *path, int offset, int size)
@@ -339,6 +1040,66 @@ void *memory_map_file(char *path, int offset, int size)
 #endif
 }
 
+void *memory_map_image(char *path, int *size)
+{
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+	void *data;
+
+	file = CreateFile(path, GENERIC_READ, 0, 0, OPEN_EXISTING, 0, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	*size = GetFileSize(file, NULL);
+	if ((*size == (int)INVALID_FILE_SIZE) || (*size == 0)) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	mapping = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	return data;
+#else
+	int fd;
+	struct stat sb;
+	void *data;
+	int flags = MAP_PRIVATE;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	fstat(fd, &sb);
+	if (!S_ISREG(sb.st_mode) || (sb.st_size == 0)) {
+		close(fd);
+		return NULL;
+	}
+	*size = sb.st_size;
+
+	/* Fault whole image in now instead of during emulation */
+#ifdef MAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+	data = mmap(0, *size, PROT_READ, flags, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+#ifdef MADV_WILLNEED
+	madvise(data, *size, MADV_WILLNEED);
+#endif
+
+	return data;
+#endif
+}
+
 void memory_unmap_file(void *data, int size)
 {
 #ifdef _WIN32
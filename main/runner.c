@@ -0,0 +1,311 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmdline.h>
+#include <log.h>
+#include <machine.h>
+#include <runner.h>
+#include <video.h>
+
+/* Number of frames run by default for each instance */
+#define DEFAULT_NUM_FRAMES	600
+
+struct runner_queue {
+	pthread_mutex_t mutex;
+	int *jobs;
+	int head;
+	int tail;
+};
+
+struct runner_worker {
+	pthread_t thread;
+	int id;
+	struct runner *runner;
+};
+
+struct runner {
+	struct runner_job *jobs;
+	struct runner_queue *queues;
+	struct runner_worker *workers;
+	int num_workers;
+};
+
+static bool runner_pop(struct runner_queue *queue, int *job);
+static bool runner_steal(struct runner_queue *queue, int *job);
+static bool runner_get_job(struct runner_worker *worker, int *job);
+static void runner_pin(struct runner_worker *worker);
+static void runner_exec(struct runner_job *job);
+static void *runner_thread(void *data);
+
+/* Command-line parameters */
+static int num_instances;
+PARAM(num_instances, int, "instances", NULL,
+	"Runs a number of headless machine instances in parallel")
+static int num_threads;
+PARAM(num_threads, int, "threads", NULL,
+	"Sets number of worker threads used for instances")
+static int num_frames = DEFAULT_NUM_FRAMES;
+PARAM(num_frames, int, "frames", NULL,
+	"Sets number of frames run by each instance")
+static char *jit_mode_list;
+PARAM(jit_mode_list, string, "instance-jit", NULL,
+	"Sets JIT modes given to instances in turn (comma-separated list)")
+
+bool runner_pop(struct runner_queue *queue, int *job)
+{
+	bool found;
+
+	/* Take job from the head of own queue */
+	pthread_mutex_lock(&queue->mutex);
+	found = (queue->head != queue->tail);
+	if (found)
+		*job = queue->jobs[queue->head++];
+	pthread_mutex_unlock(&queue->mutex);
+	return found;
+}
+
+bool runner_steal(struct runner_queue *queue, int *job)
+{
+	bool found;
+
+	/* Take job from the tail of another worker queue */
+	pthread_mutex_lock(&queue->mutex);
+	found = (queue->head != queue->tail);
+	if (found)
+		*job = queue->jobs[--queue->tail];
+	pthread_mutex_unlock(&queue->mutex);
+	return found;
+}
+
+bool runner_get_job(struct runner_worker *worker, int *job)
+{
+	struct runner *runner = worker->runner;
+	int i;
+
+	/* Run own jobs first */
+	if (runner_pop(&runner->queues[worker->id], job))
+		return true;
+
+	/* Steal from other workers (no jobs are added once started, so all
+	queues being empty means work is complete) */
+	for (i = 1; i < runner->num_workers; i++)
+		if (runner_steal(&runner->queues[(worker->id + i) %
+			runner->num_workers], job))
+			return true;
+
+	return false;
+}
+
+void runner_pin(struct runner_worker *worker)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	long num_cpus;
+
+	/* Pin worker to a core (wrapping around if there are more workers) */
+	num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_cpus <= 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(worker->id % num_cpus, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+		LOG_W("Could not pin worker %d!\n", worker->id);
+#else
+	/* Leave scheduling to the system */
+	(void)worker;
+#endif
+}
+
+void runner_exec(struct runner_job *job)
+{
+	struct machine *m;
+	unsigned long num_timeouts = 0;
+
+	/* Create instance (it is selected for this thread only) */
+	m = machine_create(job->machine_name, job->data_path, job->jit_mode);
+	if (!m) {
+		job->failed = true;
+		return;
+	}
+
+	/* Reset instance and run until requested number of frames is shown
+	(giving up after as many frame periods without video output) */
+	machine_reset();
+	while ((video_get_num_frames() < job->num_frames) &&
+		(num_timeouts < job->num_frames))
+		if (!machine_run_frame())
+			num_timeouts++;
+	job->num_frames_run = video_get_num_frames();
+
+	/* Report instances which did not show all frames */
+	if (job->num_frames_run < job->num_frames)
+		LOG_W("Instance showed %lu frames out of %lu!\n",
+			job->num_frames_run, job->num_frames);
+
+	machine_destroy(m);
+}
+
+void *runner_thread(void *data)
+{
+	struct runner_worker *worker = data;
+	int job;
+
+	runner_pin(worker);
+
+	/* Run one instance at a time until no jobs are left */
+	while (runner_get_job(worker, &job))
+		runner_exec(&worker->runner->jobs[job]);
+
+	return NULL;
+}
+
+bool runner_run(struct runner_job *jobs, int num_jobs, int num_workers)
+{
+	struct runner runner;
+	struct runner_queue *queue;
+	bool rc = true;
+	int i;
+
+	/* Default to one worker per online core and never more than jobs */
+	if (num_workers <= 0)
+		num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_workers > num_jobs)
+		num_workers = num_jobs;
+	if (num_workers <= 0)
+		num_workers = 1;
+	LOG_I("Runner: %d instances on %d workers\n", num_jobs, num_workers);
+
+	runner.jobs = jobs;
+	runner.num_workers = num_workers;
+	runner.queues = calloc(num_workers, sizeof(struct runner_queue));
+	runner.workers = calloc(num_workers, sizeof(struct runner_worker));
+
+	/* Distribute jobs across worker queues in a round-robin fashion */
+	for (i = 0; i < num_workers; i++) {
+		queue = &runner.queues[i];
+		pthread_mutex_init(&queue->mutex, NULL);
+		queue->jobs = malloc(num_jobs * sizeof(int));
+	}
+	for (i = 0; i < num_jobs; i++) {
+		queue = &runner.queues[i % num_workers];
+		queue->jobs[queue->tail++] = i;
+		jobs[i].num_frames_run = 0;
+		jobs[i].failed = false;
+	}
+
+	/* Start workers (the calling thread waits for them) */
+	for (i = 0; i < num_workers; i++) {
+		runner.workers[i].id = i;
+		runner.workers[i].runner = &runner;
+		if (pthread_create(&runner.workers[i].thread, NULL,
+			runner_thread, &runner.workers[i])) {
+			LOG_E("Could not create worker %d!\n", i);
+			runner.num_workers = i;
+			rc = false;
+			break;
+		}
+	}
+
+	/* Wait for workers to complete */
+	for (i = 0; i < runner.num_workers; i++)
+		pthread_join(runner.workers[i].thread, NULL);
+
+	/* Free queues and workers */
+	for (i = 0; i < num_workers; i++) {
+		pthread_mutex_destroy(&runner.queues[i].mutex);
+		free(runner.queues[i].jobs);
+	}
+	free(runner.queues);
+	free(runner.workers);
+
+	/* Report failure if any instance could not be run */
+	for (i = 0; i < num_jobs; i++)
+		if (jobs[i].failed)
+			rc = false;
+
+	return rc;
+}
+
+bool runner_requested()
+{
+	return (num_instances > 0);
+}
+
+bool runner_run_all()
+{
+	struct runner_job *jobs;
+	struct timespec start_time;
+	struct timespec end_time;
+	unsigned long total_frames = 0;
+	double real_time;
+	char *modes = NULL;
+	char **jit_modes = NULL;
+	int num_jit_modes = 0;
+	char *token;
+	char *saveptr;
+	bool rc;
+	int i;
+
+	/* Validate frame count option */
+	if (num_frames <= 0) {
+		LOG_E("Number of frames should be positive!\n");
+		return false;
+	}
+
+	/* Force null frontends as others cannot be driven from several
+	threads at once (video selects the null input frontend) */
+	if (!cmdline_set_param("video", NULL, "null") ||
+		!cmdline_set_param("audio", NULL, "null")) {
+		LOG_E("Could not select null frontends!\n");
+		return false;
+	}
+
+	/* Split JIT mode list if any */
+	if (jit_mode_list) {
+		modes = strdup(jit_mode_list);
+		for (token = strtok_r(modes, ",", &saveptr); token;
+			token = strtok_r(NULL, ",", &saveptr)) {
+			jit_modes = realloc(jit_modes, (num_jit_modes + 1) *
+				sizeof(char *));
+			jit_modes[num_jit_modes++] = token;
+		}
+	}
+
+	/* Create jobs running command-line machine and path, cycling through
+	JIT modes (CPU options are used if none is given) */
+	jobs = calloc(num_instances, sizeof(struct runner_job));
+	for (i = 0; i < num_instances; i++) {
+		jobs[i].num_frames = num_frames;
+		if (num_jit_modes > 0)
+			jobs[i].jit_mode = jit_modes[i % num_jit_modes];
+	}
+
+	/* Run all instances */
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	rc = runner_run(jobs, num_instances, num_threads);
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+	real_time = (end_time.tv_sec - start_time.tv_sec) +
+		(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+	/* Report aggregate results */
+	for (i = 0; i < num_instances; i++)
+		total_frames += jobs[i].num_frames_run;
+	LOG_I("Runner: %d instances, %lu frames in %.3fs\n", num_instances,
+		total_frames, real_time);
+	LOG_I("Runner: %.2f frames/s aggregate, %.2f frames/s per instance\n",
+		total_frames / real_time,
+		total_frames / real_time / num_instances);
+
+	free(jobs);
+	free(jit_modes);
+	free(modes);
+	return rc;
+}
+
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <cmdline.h>
 #include <input.h>
@@ -6,6 +7,11 @@
 #include <log.h>
 #include <video.h>
 
+struct video_context {
+	struct video_frontend *frontend;
+	unsigned long num_frames;
+};
+
 /* Command-line parameters */
 static char *video_fe_name;
 PARAM(video_fe_name, string, "video", NULL, "Selects video frontend")
@@ -13,7 +19,23 @@ static int scale = 1;
 PARAM(scale, int, "scale", NULL, "Applies a screen scale ratio")
 
 struct list_link *video_frontends;
-static struct video_frontend *frontend;
+static __thread struct video_context *ctx;
+
+struct video_context *video_create_context()
+{
+	/* Allocate empty context (no frontend and no frames displayed) */
+	return calloc(1, sizeof(struct video_context));
+}
+
+void video_set_context(struct video_context *context)
+{
+	ctx = context;
+}
+
+void video_destroy_context(struct video_context *context)
+{
+	free(context);
+}
 
 bool video_init(int width, int height)
 {
@@ -21,7 +43,7 @@ bool video_init(int width, int height)
 	struct video_frontend *fe;
 	int scale = 1;
 
-	if (frontend) {
+	if (ctx->frontend) {
 		LOG_E("Video frontend already initialized!\n");
 		return false;
 	}
@@ -48,7 +70,7 @@ bool video_init(int width, int height)
 			if (!fe->init(width, height, scale))
 				return false;
 
-			frontend = fe;
+			ctx->frontend = fe;
 
 			/* Initialize input frontend */
 			return input_init(fe->input);
@@ -63,15 +85,18 @@ bool video_init(int width, int height)
 
 video_window_t *video_get_window()
 {
-	if (frontend->get_window)
-		return frontend->get_window();
+	if (ctx->frontend->get_window)
+		return ctx->frontend->get_window();
 	return NULL;
 }
 
 void video_update()
 {
-	if (frontend->update)
-		frontend->update();
+	/* Count displayed frames */
+	ctx->num_frames++;
+
+	if (ctx->frontend->update)
+		ctx->frontend->update();
 
 	/* Update input sub-system as well */
 	input_update();
@@ -79,35 +104,40 @@ void video_update()
 
 void video_lock()
 {
-	if (frontend->lock)
-		frontend->lock();
+	if (ctx->frontend->lock)
+		ctx->frontend->lock();
 }
 
 void video_unlock()
 {
-	if (frontend->unlock)
-		frontend->unlock();
+	if (ctx->frontend->unlock)
+		ctx->frontend->unlock();
+}
+
+unsigned long video_get_num_frames()
+{
+	return ctx->num_frames;
 }
 
 struct color video_get_pixel(int x, int y)
 {
 	struct color default_color = { 0, 0, 0 };
-	if (frontend->get_pixel)
-		return frontend->get_pixel(x, y);
+	if (ctx->frontend->get_pixel)
+		return ctx->frontend->get_pixel(x, y);
 	return default_color;
 }
 
 void video_set_pixel(int x, int y, struct color color)
 {
-	if (frontend->set_pixel)
-		frontend->set_pixel(x, y, color);
+	if (ctx->frontend->set_pixel)
+		ctx->frontend->set_pixel(x, y, color);
 }
 
 void video_deinit()
 {
-	if (frontend->deinit)
-		frontend->deinit();
+	if (ctx->frontend->deinit)
+		ctx->frontend->deinit();
 	input_deinit();
-	frontend = NULL;
+	ctx->frontend = NULL;
 }
 